@@ -0,0 +1,167 @@
+#include "attacks.h"
+
+#include <vector>
+
+namespace abra::attacks {
+
+magic bishop_magics[64];
+magic rook_magics[64];
+
+bitboard knight_table[64];
+bitboard king_table[64];
+bitboard pawn_table[2][64];
+bitboard between_table[64][64];
+bitboard line_table[64][64];
+
+namespace {
+
+// sizes of the shared tables for all squares (sum of 2^mask_bits)
+bitboard bishop_table[0x1480];
+bitboard rook_table[0x19000];
+
+const int bishop_dirs[4][2] = {{-1, -1}, {-1, 1}, {1, -1}, {1, 1}};
+const int rook_dirs[4][2] = {{-1, 0}, {1, 0}, {0, -1}, {0, 1}};
+
+// walk each direction until the edge or the first blocker (slow, init only)
+bitboard slide_attacks(square s, bitboard occupied, const int dirs[4][2]) {
+  auto attacks = bitboard{0};
+  for (int d = 0; d < 4; d++) {
+    int r = get_row(s) + dirs[d][0], c = get_col(s) + dirs[d][1];
+    while (0 <= r && r < 8 && 0 <= c && c < 8) {
+      set_bit(attacks, 8 * r + c);
+      if (test_bit(occupied, 8 * r + c)) break;
+      r += dirs[d][0];
+      c += dirs[d][1];
+    }
+  }
+  return attacks;
+}
+
+// deterministic xorshift64* so the magics are the same on every run
+struct prng {
+  uint64_t s;
+  uint64_t next() {
+    s ^= s >> 12;
+    s ^= s << 25;
+    s ^= s >> 27;
+    return s * 2685821657736338717ULL;
+  }
+  // few bits set, which makes good magic candidates
+  uint64_t sparse() { return next() & next() & next(); }
+};
+
+void init_magics(magic magics[64], bitboard *table, const int dirs[4][2]) {
+  bitboard edge_rows = 0, edge_cols = 0;
+  for (int i = 0; i < 8; i++) {
+    set_bit(edge_rows, i);
+    set_bit(edge_rows, 56 + i);
+    set_bit(edge_cols, 8 * i);
+    set_bit(edge_cols, 8 * i + 7);
+  }
+
+  auto occupancy = std::vector<bitboard>(4096), reference = occupancy;
+  auto size = 0;
+#ifndef __BMI2__
+  auto rng = prng{0x9e3779b97f4a7c15ULL};
+  auto epoch = std::vector<int>(4096, 0);
+  auto attempt = 0;
+#endif
+
+  for (square s = 0; s < 64; s++) {
+    // edges of the board never block, unless the slider is on them
+    auto row_edges = edge_rows & ~(bitboard{0xff} << (8 * get_row(s)));
+    auto col_edges = edge_cols & ~(bitboard{0x0101010101010101} << get_col(s));
+
+    auto &m = magics[s];
+    m.mask = slide_attacks(s, 0, dirs) & ~(row_edges | col_edges);
+    m.shift = 64 - popcount(m.mask);
+    // 2^bits slots per square, pext and the magics index the same range
+    m.attacks = (s == 0 ? table : magics[s - 1].attacks + size);
+
+    // enumerate all subsets of mask (carry-rippler)
+    size = 0;
+    auto b = bitboard{0};
+    do {
+      occupancy[size] = b;
+      reference[size] = slide_attacks(s, b, dirs);
+      size++;
+      b = (b - m.mask) & m.mask;
+    } while (b);
+
+#ifdef __BMI2__
+    // pext packs the mask bits densely, every subset has its own slot
+    for (int i = 0; i < size; i++)
+      m.attacks[m.index(occupancy[i])] = reference[i];
+#else
+    // find a multiplier mapping every subset to a slot without a conflict
+    for (int i = 0; i < size;) {
+      for (m.magic = 0; popcount((m.mask * m.magic) >> 56) < 6;)
+        m.magic = rng.sparse();
+      attempt++;
+      for (i = 0; i < size; i++) {
+        auto idx = m.index(occupancy[i]);
+        if (epoch[idx] < attempt) {
+          epoch[idx] = attempt;
+          m.attacks[idx] = reference[i];
+        } else if (m.attacks[idx] != reference[i]) {
+          break;
+        }
+      }
+    }
+#endif
+  }
+}
+
+// squares reached from square by each (row, col) step, if on the board
+bitboard step_attacks(square s, const int steps[][2], int n) {
+  auto attacks = bitboard{0};
+  for (int i = 0; i < n; i++) {
+    int r = get_row(s) + steps[i][0], c = get_col(s) + steps[i][1];
+    if (0 <= r && r < 8 && 0 <= c && c < 8) set_bit(attacks, 8 * r + c);
+  }
+  return attacks;
+}
+
+void init_steppers() {
+  const int knight_steps[8][2] = {{-2, -1}, {-2, 1}, {2, -1}, {2, 1},
+                                  {-1, -2}, {1, -2}, {-1, 2}, {1, 2}};
+  const int king_steps[8][2] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1},
+                                {0, 1},   {1, -1}, {1, 0},  {1, 1}};
+  // white pawns move towards row 0
+  const int white_pawn_steps[2][2] = {{-1, -1}, {-1, 1}};
+  const int black_pawn_steps[2][2] = {{1, -1}, {1, 1}};
+  for (square s = 0; s < 64; s++) {
+    knight_table[s] = step_attacks(s, knight_steps, 8);
+    king_table[s] = step_attacks(s, king_steps, 8);
+    pawn_table[0][s] = step_attacks(s, white_pawn_steps, 2);
+    pawn_table[1][s] = step_attacks(s, black_pawn_steps, 2);
+  }
+}
+
+// needs the slider tables
+void init_lines() {
+  for (square a = 0; a < 64; a++) {
+    for (square b = 0; b < 64; b++) {
+      between_table[a][b] = line_table[a][b] = 0;
+      if (a == b) continue;
+      auto ab = to_bitboard(a) | to_bitboard(b);
+      for (auto slider : {bishop_attacks, rook_attacks}) {
+        if (!test_bit(slider(a, 0), b)) continue;
+        line_table[a][b] = (slider(a, 0) & slider(b, 0)) | ab;
+        between_table[a][b] =
+            slider(a, to_bitboard(b)) & slider(b, to_bitboard(a));
+      }
+    }
+  }
+}
+
+}  // namespace
+
+void init() {
+  init_magics(bishop_magics, bishop_table, bishop_dirs);
+  init_magics(rook_magics, rook_table, rook_dirs);
+  init_steppers();
+  init_lines();
+}
+
+}  // namespace abra::attacks
@@ -0,0 +1,81 @@
+#ifndef ABRA_ATTACKS_H
+#define ABRA_ATTACKS_H
+
+#include <cstdint>
+
+#include "types.h"
+
+// built with -mbmi2 the tables are indexed with pext instead of magic
+// multiplication, see the Makefile
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif
+
+namespace abra::attacks {
+
+// precomputed sliding attacks for one square, see
+// https://www.chessprogramming.org/Magic_Bitboards
+struct magic {
+  bitboard mask;   // relevant occupancy (board edges excluded)
+  bitboard magic;  // multiplier, unused with pext
+  bitboard *attacks;
+  unsigned shift;
+
+  unsigned index(bitboard) const;
+};
+
+extern magic bishop_magics[64];
+extern magic rook_magics[64];
+
+extern bitboard knight_table[64];
+extern bitboard king_table[64];
+extern bitboard pawn_table[2][64];
+extern bitboard between_table[64][64];
+extern bitboard line_table[64][64];
+
+// build the tables, call once at startup before any move generation
+void init();
+
+inline unsigned magic::index(bitboard occupied) const {
+#ifdef __BMI2__
+  return static_cast<unsigned>(_pext_u64(occupied, mask));
+#else
+  return static_cast<unsigned>(((occupied & mask) * magic) >> shift);
+#endif
+}
+
+// squares attacked by a slider on square, given all occupied squares
+// the first blocker in each direction is included regardless of its color
+inline bitboard bishop_attacks(square s, bitboard occupied) {
+  auto &m = bishop_magics[s];
+  return m.attacks[m.index(occupied)];
+}
+
+inline bitboard rook_attacks(square s, bitboard occupied) {
+  auto &m = rook_magics[s];
+  return m.attacks[m.index(occupied)];
+}
+
+inline bitboard queen_attacks(square s, bitboard occupied) {
+  return bishop_attacks(s, occupied) | rook_attacks(s, occupied);
+}
+
+inline bitboard knight_attacks(square s) { return knight_table[s]; }
+
+inline bitboard king_attacks(square s) { return king_table[s]; }
+
+// squares attacked by a pawn of color on square
+inline bitboard pawn_attacks(color c, square s) {
+  assert(c != color::none);
+  return pawn_table[c == color::white ? 0 : 1][s];
+}
+
+// squares strictly between two squares on a line, empty if not aligned
+inline bitboard between(square a, square b) { return between_table[a][b]; }
+
+// whole board line through two squares (including both), empty if not aligned
+inline bitboard line(square a, square b) { return line_table[a][b]; }
+
+}  // namespace abra::attacks
+
+#endif
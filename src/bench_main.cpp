@@ -0,0 +1,369 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "attacks.h"
+#include "game.h"
+#include "material.h"
+#include "nnue.h"
+#include "notation.h"
+#include "pawns.h"
+#include "search.h"
+#include "types.h"
+
+using namespace abra;
+using std::cout;
+
+struct bench_config {
+  std::string mode;
+  int depth;
+  size_t hash_mb;
+  int threads;
+  search_driver driver;
+  search_options options;
+  int movetime;
+  std::string epd;
+  std::shared_ptr<const nnue::network> net;  // nullptr for piece-square
+};
+
+// clang-format off
+const std::vector<std::string> bench_positions = {
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+  "r2q1rk1/ppp2ppp/2n1bn2/2b1p3/3pP3/3P1NPP/PPP1NPB1/R1BQ1RK1 b - - 0 9",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+};
+
+// tactical positions with a known best move, from win at chess
+const std::vector<std::string> epd_positions = {
+  "2rr3k/pp3pp1/1nnqbN1p/3pN3/2pP4/2P3Q1/PPB4P/R4RK1 w - - bm Qg6; id \"WAC.001\";",
+  "8/7p/5k2/5p2/p1p2P2/Pr1pPK2/1P1R3P/8 b - - bm Rxb2; id \"WAC.002\";",
+  "5rk1/1ppb3p/p1pb4/6q1/3P1p1r/2P1R2P/PP1BQ1P1/5RK1 b - - bm Rg3; id \"WAC.003\";",
+  "r1bq2rk/pp3pbp/2p1p1pQ/7P/3P4/2PB1N2/PP3PPR/2KR4 w - - bm Qxh7+; id \"WAC.004\";",
+  "5k2/6pp/p1qN4/1p1p4/3P4/2PKP2Q/PP3r2/3R4 b - - bm Qc4+; id \"WAC.005\";",
+  "7k/p7/1R5K/6r1/6p1/6P1/8/8 w - - bm Rb7; id \"WAC.006\";",
+  "rnbqkb1r/pppp1ppp/8/4P3/6n1/7P/PPPNPPP1/R1BQKBNR b KQkq - bm Ne3; id \"WAC.007\";",
+  "r4q1k/p2bR1rp/2p2Q1N/5p2/5p2/2P5/PP3PPP/R5K1 w - - bm Rf7; id \"WAC.008\";",
+  "3q1rk1/p4pp1/2pb3p/3p4/6Pr/1PNQ4/P1PB1PP1/4RRK1 b - - bm Bh2+; id \"WAC.009\";",
+  "2br2k1/2q3rn/p2NppQ1/2p1P3/Pp5R/4P3/1P3PPP/3R2K1 w - - bm Rxh7; id \"WAC.010\";",
+  "r1b1kb1r/3q1ppp/pBp1pn2/8/Np3P2/5B2/PPP3PP/R2Q1RK1 w kq - bm Bxc6; id \"WAC.011\";",
+  "4k1r1/2p3r1/1pR1p3/3pP2p/3P2qP/P4N2/1PQ4P/5R1K b - - bm Qxf3+; id \"WAC.012\";",
+  "5rk1/pp4p1/2n1p2p/2Npq3/2p5/6P1/P3P1BP/R4Q1K w - - bm Qxf8+; id \"WAC.013\";",
+  "r2rb1k1/pp1q1p1p/2n1p1p1/2bp4/5P2/PP1BPR1Q/1BPN2PP/R5K1 w - - bm Qxh7+; id \"WAC.014\";",
+  "1R6/1brk2p1/4p2p/p1P1Pp2/P7/6P1/1P4P1/2R3K1 w - - bm Rxb7; id \"WAC.015\";",
+};
+// clang-format on
+
+long long elapsed_us(std::chrono::steady_clock::time_point begin) {
+  using namespace std::chrono;
+  return duration_cast<microseconds>(steady_clock::now() - begin).count();
+}
+
+const char* driver_name(search_driver d) {
+  return (d == search_driver::pvs ? "pvs" : "mtdf");
+}
+
+// iterative deepening to a fixed depth on every position
+void bench_search(bench_config& config) {
+  auto total_nodes = uint64_t{0}, pawn_probes = uint64_t{0},
+       pawn_hits = uint64_t{0}, material_probes = uint64_t{0},
+       material_hits = uint64_t{0};
+  auto total_us = 0LL;
+  for (auto& fen : bench_positions) {
+    auto strat = minimax_search{config.hash_mb};
+    strat.set_threads(config.threads);
+    strat.set_driver(config.driver);
+    strat.set_options(config.options);
+    strat.set_network(config.net);
+    auto limits = search_limits{};
+    limits.depth = config.depth;
+    auto begin = std::chrono::steady_clock::now();
+    auto guess = strat.choose_move(game{fen}, limits).first;
+    auto us = elapsed_us(begin);
+    cout << fen << "\n  score " << guess << " depth " << strat.get_depth()
+         << " nodes " << strat.get_nodes() << " (" << strat.get_qnodes()
+         << " quiescence) " << us / 1000 << "ms\n";
+    total_nodes += strat.get_nodes();
+    total_us += us;
+    pawn_probes += strat.get_pawn_probes();
+    pawn_hits += strat.get_pawn_hits();
+    material_probes += strat.get_material_probes();
+    material_hits += strat.get_material_hits();
+  }
+  cout << "total: " << total_nodes << " nodes " << total_us / 1000 << "ms "
+       << (total_us > 0 ? total_nodes * 1000000 / total_us : 0) << " nps\n";
+  cout << "pawn table: " << pawn_probes << " probes "
+       << (pawn_probes > 0 ? pawn_hits * 100 / pawn_probes : 0) << "% hits ("
+       << pawns::table::default_size << " entries per thread)\n";
+  cout << "material table: " << material_probes << " probes "
+       << (material_probes > 0 ? material_hits * 100 / material_probes : 0)
+       << "% hits (" << material::table::default_size
+       << " entries per thread)\n";
+  cout << "position state written per node: " << sizeof(undo_info)
+       << " bytes (make/unmake) vs " << sizeof(game)
+       << " bytes + history (copy-make)\n";
+}
+
+// nodes and time to reach the same depth with each root driver, every search
+// starts from an empty table
+void bench_drivers(bench_config& config) {
+  const search_driver drivers[] = {search_driver::mtdf, search_driver::pvs};
+  uint64_t total_nodes[2] = {0, 0};
+  long long total_us[2] = {0, 0};
+  for (auto& fen : bench_positions) {
+    cout << fen << "\n";
+    for (int i = 0; i < 2; i++) {
+      auto strat = minimax_search{config.hash_mb};
+      strat.set_threads(config.threads);
+      strat.set_driver(drivers[i]);
+      strat.set_options(config.options);
+      strat.set_network(config.net);
+      auto limits = search_limits{};
+      limits.depth = config.depth;
+      auto begin = std::chrono::steady_clock::now();
+      auto [score, m] = strat.choose_move(game{fen}, limits);
+      auto us = elapsed_us(begin);
+      cout << "  " << driver_name(drivers[i]) << ": score " << score
+           << " move " << notation::to_AN(m) << " nodes "
+           << strat.get_nodes() << " " << us / 1000 << "ms\n";
+      total_nodes[i] += strat.get_nodes();
+      total_us[i] += us;
+    }
+  }
+  for (int i = 0; i < 2; i++)
+    cout << driver_name(drivers[i]) << " total: " << total_nodes[i]
+         << " nodes " << total_us[i] / 1000 << "ms\n";
+}
+
+// standard algebraic notation without check marks, to match epd moves
+std::string to_san(const game& g, move m) {
+  auto p = g.piece_at(m.from());
+  if (m.flag() == move_flag::castling)
+    return (m.to() > m.from() ? "O-O" : "O-O-O");
+  auto capture = (m.flag() == move_flag::en_passant ||
+                  !g.piece_at(m.to()).is_empty());
+  auto from = notation::to_AN(m.from()), to = notation::to_AN(m.to());
+  auto san = std::string{};
+  if (p.ptype == piece_type::pawn) {
+    if (capture) san += from.substr(0, 1) + "x";
+    san += to;
+    if (m.flag() == move_flag::promotion)
+      san += "=" + notation::to_AN(piece{color::white, m.promotion()});
+    return san;
+  }
+  san = notation::to_AN(piece{color::white, p.ptype});
+  // name the file, rank or both when another piece of the same type can
+  // move to the same square
+  auto moves = move_list{};
+  g.get_moves(moves);
+  auto same_file = false, same_rank = false, ambiguous = false;
+  for (auto other : moves) {
+    if (other.to() != m.to() || other.from() == m.from() ||
+        !(g.piece_at(other.from()) == p))
+      continue;
+    ambiguous = true;
+    auto other_from = notation::to_AN(other.from());
+    same_file |= (other_from[0] == from[0]);
+    same_rank |= (other_from[1] == from[1]);
+  }
+  if (ambiguous && !same_file)
+    san += from.substr(0, 1);
+  else if (ambiguous && !same_rank)
+    san += from.substr(1, 1);
+  else if (ambiguous)
+    san += from;
+  return san + (capture ? "x" : "") + to;
+}
+
+// epd line with a best move operation, the moves are returned without
+// check marks
+std::pair<std::string, std::vector<std::string>> parse_epd(
+    const std::string& line) {
+  auto tokens = notation::split_string(line, ' ');
+  if (tokens.size() < 6)
+    throw new std::invalid_argument("invalid epd '" + line + "'");
+  auto fen = tokens[0] + " " + tokens[1] + " " + tokens[2] + " " + tokens[3] +
+             " 0 1";
+  auto best = std::vector<std::string>{};
+  auto in_bm = false;
+  for (size_t i = 4; i < tokens.size(); i++) {
+    auto token = tokens[i];
+    if (token == "bm") {
+      in_bm = true;
+      continue;
+    }
+    if (!in_bm) continue;
+    auto last = (token.back() == ';');
+    token.erase(std::remove_if(token.begin(), token.end(),
+                               [](char c) {
+                                 return c == '+' || c == '#' || c == ';' ||
+                                        c == '!' || c == '?';
+                               }),
+                token.end());
+    best.push_back(token);
+    if (last) break;
+  }
+  if (best.empty())
+    throw new std::invalid_argument("epd '" + line + "' has no best move");
+  return {fen, best};
+}
+
+// solve rate on a tactical suite with the full width search and with the
+// selected pruning, both get the same time per position
+void bench_epd(bench_config& config) {
+  auto lines = epd_positions;
+  if (!config.epd.empty()) {
+    auto file = std::ifstream{config.epd};
+    if (!file) throw new std::invalid_argument("cannot read " + config.epd);
+    lines.clear();
+    for (auto line = std::string{}; std::getline(file, line);)
+      if (!line.empty()) lines.push_back(line);
+  }
+  const search_options variants[] = {search_options{false, false, false},
+                                     config.options};
+  const char* names[] = {"full width", "selective"};
+  int solved[2] = {0, 0}, depths[2] = {0, 0};
+  for (auto& line : lines) {
+    auto [fen, best] = parse_epd(line);
+    auto pos = game{fen};
+    cout << line << "\n";
+    for (int i = 0; i < 2; i++) {
+      auto strat = minimax_search{config.hash_mb};
+      strat.set_threads(config.threads);
+      strat.set_driver(config.driver);
+      strat.set_options(variants[i]);
+      strat.set_network(config.net);
+      auto limits = search_limits{};
+      limits.movetime = config.movetime;
+      auto m = strat.choose_move(pos, limits).second;
+      auto san = to_san(pos, m);
+      auto ok = std::find(best.begin(), best.end(), san) != best.end();
+      cout << "  " << names[i] << ": " << san << (ok ? " ok" : " wrong")
+           << " depth " << strat.get_depth() << "\n";
+      solved[i] += ok;
+      depths[i] += strat.get_depth();
+    }
+  }
+  for (int i = 0; i < 2; i++)
+    cout << names[i] << ": solved " << solved[i] << "/" << lines.size()
+         << " average depth " << depths[i] / static_cast<int>(lines.size())
+         << "\n";
+}
+
+// walk the legal move tree by copying the position for every child
+uint64_t walk_copy(const game& g, int depth) {
+  if (depth <= 0) return 1;
+  auto nodes = uint64_t{1};
+  auto moves = move_list{};
+  g.get_moves(moves);
+  for (auto m : moves) {
+    game new_game{g};
+    new_game.make_move(m);
+    nodes += walk_copy(new_game, depth - 1);
+  }
+  return nodes;
+}
+
+// walk the same tree on a single position
+uint64_t walk_in_place(game& g, int depth) {
+  if (depth <= 0) return 1;
+  auto nodes = uint64_t{1};
+  auto moves = move_list{};
+  g.get_moves(moves);
+  for (auto m : moves) {
+    g.make_move(m);
+    nodes += walk_in_place(g, depth - 1);
+    g.unmake_move();
+  }
+  return nodes;
+}
+
+void bench_make(bench_config& config) {
+  auto copy_nodes = uint64_t{0}, in_place_nodes = uint64_t{0};
+  auto copy_us = 0LL, in_place_us = 0LL;
+  for (auto& fen : bench_positions) {
+    auto pos = game{fen};
+    auto begin = std::chrono::steady_clock::now();
+    copy_nodes += walk_copy(pos, config.depth);
+    copy_us += elapsed_us(begin);
+    begin = std::chrono::steady_clock::now();
+    in_place_nodes += walk_in_place(pos, config.depth);
+    in_place_us += elapsed_us(begin);
+  }
+  auto report = [](const char* name, uint64_t nodes, long long us,
+                   size_t bytes) {
+    cout << name << ": " << nodes << " nodes " << us / 1000 << "ms "
+         << (us > 0 ? nodes * 1000000 / us : 0) << " nps, " << bytes
+         << " bytes written per node\n";
+  };
+  report("copy-make", copy_nodes, copy_us, sizeof(game));
+  report("make/unmake", in_place_nodes, in_place_us, sizeof(undo_info));
+}
+
+int main(int argc, const char* argv[]) {
+  attacks::init();
+  try {
+    auto config = bench_config{
+        "search", 4,   16, 1, search_driver::pvs, search_options{}, 1000,
+        "",       nullptr};
+    for (int i = 1; i < argc; i += 2) {
+      auto flg = std::string{argv[i]};
+      if (i + 1 >= argc)
+        throw new std::invalid_argument(flg + " does not have a value");
+      auto val = std::string{argv[i + 1]};
+      if (flg == "--mode") {
+        if (val != "search" && val != "make" && val != "drivers" &&
+            val != "epd")
+          throw new std::invalid_argument("invalid mode " + val);
+        config.mode = val;
+      } else if (flg == "--depth") {
+        config.depth = std::stoi(val);
+      } else if (flg == "--hash") {
+        config.hash_mb = std::stoul(val);
+      } else if (flg == "--threads") {
+        config.threads = std::stoi(val);
+      } else if (flg == "--driver") {
+        if (val == "mtdf")
+          config.driver = search_driver::mtdf;
+        else if (val == "pvs")
+          config.driver = search_driver::pvs;
+        else
+          throw new std::invalid_argument("invalid driver " + val);
+      } else if (flg == "--pruning") {
+        if (val != "on" && val != "off")
+          throw new std::invalid_argument("invalid pruning " + val);
+        auto on = (val == "on");
+        config.options = search_options{on, on, on};
+      } else if (flg == "--movetime") {
+        config.movetime = std::stoi(val);
+      } else if (flg == "--epd") {
+        config.epd = val;
+      } else if (flg == "--nnue") {
+        config.net = nnue::load(val);
+      } else {
+        throw new std::invalid_argument("invalid arguement " + flg);
+      }
+    }
+    if (config.net)
+      cout << "network kernels: " << nnue::simd_name() << "\n";
+    if (config.mode == "make")
+      bench_make(config);
+    else if (config.mode == "drivers")
+      bench_drivers(config);
+    else if (config.mode == "epd")
+      bench_epd(config);
+    else
+      bench_search(config);
+  } catch (std::invalid_argument* err) {
+    cout << "ERROR: " << err->what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,226 @@
+#ifndef ABRA_EVALUATION_H
+#define ABRA_EVALUATION_H
+
+#include <algorithm>
+#include <cstdint>
+
+#include "types.h"
+
+// tapered material and piece-square evaluation, kept incrementally by game
+namespace abra::evaluation {
+
+// clang-format off
+// Piece Square Tables: taken from https://www.chessprogramming.org/Simplified_Evaluation_Function
+// modify to change evaluation function & bot behaviour
+// midgame
+constexpr int pst_mg[][64] = {
+  // pawn
+  {
+     0,  0,  0,  0,  0,  0,  0,  0,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    10, 10, 20, 30, 30, 20, 10, 10,
+     5,  5, 10, 25, 25, 10,  5,  5,
+     0,  0,  0, 20, 20,  0,  0,  0,
+     5, -5,-10,  0,  0,-10, -5,  5,
+     5, 10, 10,-20,-20, 10, 10,  5,
+     0,  0,  0,  0,  0,  0,  0,  0
+  },
+  // knight
+  {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50,
+  },
+  // bishop
+  {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20,
+  },
+  // rook
+  {
+    0,  0,  0,  0,  0,  0,  0,  0,
+    5, 10, 10, 10, 10, 10, 10,  5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    0,  0,  0,  5,  5,  0,  0,  0
+  },
+  // queen
+  {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20
+  },
+  // king - midgame
+  {
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -30,-40,-40,-50,-50,-40,-40,-30,
+    -20,-30,-30,-40,-40,-30,-30,-20,
+    -10,-20,-20,-20,-20,-20,-20,-10,
+     20, 20,  0,  0,  0,  0, 20, 20,
+     20, 30, 10,  0,  0, 10, 30, 20
+  }
+};
+
+// endgame, pawns are worth more the further they are, the king belongs in
+// the centre
+constexpr int pst_eg[][64] = {
+  // pawn
+  {
+     0,  0,  0,  0,  0,  0,  0,  0,
+    80, 80, 80, 80, 80, 80, 80, 80,
+    50, 50, 50, 50, 50, 50, 50, 50,
+    30, 30, 30, 30, 30, 30, 30, 30,
+    15, 15, 15, 15, 15, 15, 15, 15,
+     5,  5,  5,  5,  5,  5,  5,  5,
+     0,  0,  0,  0,  0,  0,  0,  0,
+     0,  0,  0,  0,  0,  0,  0,  0
+  },
+  // knight
+  {
+    -50,-40,-30,-30,-30,-30,-40,-50,
+    -40,-20,  0,  0,  0,  0,-20,-40,
+    -30,  0, 10, 15, 15, 10,  0,-30,
+    -30,  5, 15, 20, 20, 15,  5,-30,
+    -30,  0, 15, 20, 20, 15,  0,-30,
+    -30,  5, 10, 15, 15, 10,  5,-30,
+    -40,-20,  0,  5,  5,  0,-20,-40,
+    -50,-40,-30,-30,-30,-30,-40,-50,
+  },
+  // bishop
+  {
+    -20,-10,-10,-10,-10,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5, 10, 10,  5,  0,-10,
+    -10,  5,  5, 10, 10,  5,  5,-10,
+    -10,  0, 10, 10, 10, 10,  0,-10,
+    -10, 10, 10, 10, 10, 10, 10,-10,
+    -10,  5,  0,  0,  0,  0,  5,-10,
+    -20,-10,-10,-10,-10,-10,-10,-20,
+  },
+  // rook
+  {
+    0,  0,  0,  0,  0,  0,  0,  0,
+    5, 10, 10, 10, 10, 10, 10,  5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    -5,  0,  0,  0,  0,  0,  0, -5,
+    0,  0,  0,  5,  5,  0,  0,  0
+  },
+  // queen
+  {
+    -20,-10,-10, -5, -5,-10,-10,-20,
+    -10,  0,  0,  0,  0,  0,  0,-10,
+    -10,  0,  5,  5,  5,  5,  0,-10,
+     -5,  0,  5,  5,  5,  5,  0, -5,
+      0,  0,  5,  5,  5,  5,  0, -5,
+    -10,  5,  5,  5,  5,  5,  0,-10,
+    -10,  0,  5,  0,  0,  0,  0,-10,
+    -20,-10,-10, -5, -5,-10,-10,-20
+  },
+  // king
+  {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50
+  }
+};
+
+// piece values for P N B R Q K, kings are always on the board so theirs is
+// left out of the score
+// knights lose and rooks gain value as the board empties
+constexpr int pv_mg[] = { 100, 320, 330, 500, 900, 20000 };
+constexpr int pv_eg[] = { 120, 300, 320, 530, 930, 20000 };
+
+// game phase weight of P N B R Q K, the non-pawn material of the start
+// position is a phase of 24 (pure midgame)
+constexpr int phase_weight[] = { 0, 1, 1, 2, 4, 0 };
+constexpr int max_phase = 24;
+// clang-format on
+
+// midgame and endgame values packed in one int (midgame in the upper 16
+// bits), so that both are updated by a single addition, see
+// https://www.chessprogramming.org/Tapered_Eval
+constexpr int make_score(int mg, int eg) {
+  return static_cast<int>(static_cast<unsigned>(mg) << 16) + eg;
+}
+
+// the lower half is signed, so it borrowed from the upper one if negative
+constexpr int mg_value(int s) {
+  return static_cast<int16_t>(
+      static_cast<uint16_t>((static_cast<unsigned>(s) + 0x8000) >> 16));
+}
+
+constexpr int eg_value(int s) {
+  return static_cast<int16_t>(static_cast<uint16_t>(static_cast<unsigned>(s)));
+}
+
+// interpolate between the midgame and endgame value by the phase
+inline int taper(int s, int phase) {
+  phase = std::min(phase, max_phase);  // promotions can add material
+  return (mg_value(s) * phase + eg_value(s) * (max_phase - phase)) / max_phase;
+}
+
+// packed material + piece-square value of every piece on every square,
+// signed so that white pieces count positive and black pieces negative
+struct psq_table {
+  int values[2][6][64];
+};
+
+constexpr psq_table make_psq_table() {
+  auto table = psq_table{};
+  for (int t = 0; t < 6; t++) {
+    // the king values cancel out and would not fit in 16 bits
+    auto mg = (t == 5 ? 0 : pv_mg[t]), eg = (t == 5 ? 0 : pv_eg[t]);
+    for (square s = 0; s < 64; s++) {
+      auto r = flip_square(s);  // mirrored for black
+      table.values[0][t][s] = make_score(pst_mg[t][s] + mg, pst_eg[t][s] + eg);
+      table.values[1][t][s] =
+          make_score(-(pst_mg[t][r] + mg), -(pst_eg[t][r] + eg));
+    }
+  }
+  return table;
+}
+
+inline constexpr psq_table psq = make_psq_table();
+
+inline int psq_value(piece p, square s) {
+  assert(!p.is_empty() && is_valid_square(s));
+  auto c = static_cast<int>(p.pcolor) - 1, t = static_cast<int>(p.ptype) - 1;
+  return psq.values[c][t][s];
+}
+
+inline int phase_value(piece p) {
+  return phase_weight[static_cast<int>(p.ptype) - 1];
+}
+
+}  // namespace abra::evaluation
+
+#endif
@@ -2,6 +2,9 @@
 
 #include <algorithm>
 
+#include "evaluation.h"
+#include "zobrist.h"
+
 namespace abra {
 
 const std::string _initial_fen{
@@ -9,53 +12,122 @@ const std::string _initial_fen{
 
 game::game() : game(_initial_fen) {}
 
-bool game::is_material_insufficient() const {
-  if (board.pawn) return false;  // if pawns exist, no
-  auto major_pieces = bitboard{board.queen | board.rook};
-  if (major_pieces) return false;  // if major pieces exist, no
-  auto minor_pieces = bitboard{board.knight | board.bishop};
-  auto black_minor_pieces = popcount(bitboard{board.black & minor_pieces}),
-       white_minor_pieces = popcount(bitboard{board.white & minor_pieces});
-  return black_minor_pieces <= 1 &&
-         white_minor_pieces <= 1;  // if both sides have <= 1 minor piece, no
-}
-
-// returns true iff game is over
-bool game::is_terminal() const {
-  if (halfmove_cnt >= 100 || is_material_insufficient()) return true;
-  if (get_moves().empty()) return true;
+uint64_t game::compute_hash() const {
+  auto key = uint64_t{0};
+  for (auto occupied = bitboard{board.white | board.black}; occupied;) {
+    auto i = pop_lsb(occupied);
+    key ^= zobrist::piece_key(board.get_piece(i), i);
+  }
+  key ^= zobrist::side_key(color_to_move);
+  key ^= zobrist::castling_key(castling);
+  key ^= zobrist::en_passant_key(en_passant);
+  return key;
+}
+
+uint64_t game::compute_pawn_hash() const {
+  auto key = uint64_t{0};
+  for (auto pieces = bitboard{board.pawn | board.king}; pieces;) {
+    auto i = pop_lsb(pieces);
+    key ^= zobrist::piece_key(board.get_piece(i), i);
+  }
+  return key;
+}
+
+uint64_t game::compute_material_key() const {
+  auto key = uint64_t{0};
+  for (auto occupied = bitboard{board.white | board.black}; occupied;) {
+    auto i = pop_lsb(occupied);
+    key += material::key_delta(board.get_piece(i));
+  }
+  return key;
+}
+
+int game::compute_psq_score() const {
+  auto score = 0, game_phase = 0;
+  for (auto occupied = bitboard{board.white | board.black}; occupied;) {
+    auto i = pop_lsb(occupied);
+    score += evaluation::psq_value(board.get_piece(i), i);
+    game_phase += evaluation::phase_value(board.get_piece(i));
+  }
+  return evaluation::taper(score, game_phase);
+}
+
+void game::set_network(const nnue::network *n) {
+  net = n;
+  accumulators.clear();
+  if (!net) return;
+  accumulators.emplace_back();
+  for (auto c : {color::white, color::black})
+    nnue::refresh(*net, board, c, accumulators.back());
+}
+
+// the side ahead has its score scaled down in drawish endgames
+int game::evaluate(pawns::table &pawn_table,
+                   material::table &material_table) const {
+  if (!net) {
+    auto &material_entry = material_table.probe(material_key);
+    auto &pawn_entry = pawn_table.probe(board, pawn_hash);
+    auto score =
+        evaluation::taper(psq_score + material_entry.score + pawn_entry.score,
+                          material_entry.phase);
+    return score * material_entry.scale[score > 0 ? 0 : 1] /
+           material::full_scale;
+  }
+  auto score = nnue::evaluate(*net, accumulators.back(), color_to_move);
+  return (color_to_move == color::white ? score : -score);
+}
+
+// returns true iff game is over, a mate on the last move before the 50 move
+// rule or a repetition still counts as the mate
+bool game::is_terminal() const { return !has_legal_move() || is_draw(); }
+
+// most moves are legal, so the first pseudo legal move usually answers it
+bool game::has_legal_move() const {
+  auto moves = move_list{};
+  for (auto noisy : {false, true}) {
+    moves.clear();
+    get_pseudo_moves(moves, noisy);
+    for (auto m : moves)
+      if (is_legal(m)) return true;
+  }
+  return false;
+}
+
+bool game::is_draw(int n) const {
+  return halfmove_cnt >= 100 || is_material_insufficient() || is_repetition(n);
+}
+
+// history[size - i] holds the position i plies ago, a repetition needs the
+// same side to move and at least 4 plies, and cannot reach past an
+// irreversible move (halfmove_cnt) or a null move
+bool game::is_repetition(int n) const {
+  auto size = static_cast<int>(history.size());
+  auto end = std::min(halfmove_cnt, size);
+  auto count = 0;
+  for (int i = 1; i <= end; i++) {
+    auto &u = history[size - i];
+    if (u.m == move{}) break;
+    if (i >= 4 && i % 2 == 0 && u.hash == hash && ++count >= n) return true;
+  }
   return false;
 }
 
 // returns the result of the game (should be terminal state)
 color game::get_result() const {
-  if (halfmove_cnt >= 100 || is_material_insufficient()) return color::none;
-  // reaching here means get_moves() is empty
-  if (in_check(color_to_move)) return get_opposite_color(color_to_move);
-  return color::none;  // stalemate
+  if (in_check(color_to_move) && !has_legal_move())
+    return get_opposite_color(color_to_move);
+  return color::none;  // stalemate or a draw by rule
 }
 
 // return true if color is in check
 bool game::in_check(color c) const {
   assert(c != color::none);
+  if (c == color_to_move) return static_cast<bool>(get_attack_info().checkers);
   auto &colorb = get_colorb(c);
-  return under_attack(bitboard{colorb & board.king}, get_opposite_color(c));
-}
-
-std::vector<move> game::get_moves(bool captures_only) const {
-  auto all_moves = get_moves(color_to_move);
-  auto legal_moves = std::vector<move>{};
-  legal_moves.reserve(all_moves.size());
-  auto vacant = ~bitboard{board.black | board.white};
-  std::copy_if(all_moves.begin(), all_moves.end(),
-               std::back_inserter(legal_moves), [&](move m) {
-                 // check if legal
-                 if (captures_only && test_bit(vacant, m.to)) return false;
-                 auto test_game = game{*this};
-                 test_game.make_move(m);
-                 return !test_game.in_check(color_to_move);
-               });
-  return legal_moves;
+  auto &enemyb = get_colorb(get_opposite_color(c));
+  square king_sq = lsb(colorb & board.king);
+  return static_cast<bool>(attackers_to(king_sq, board.white | board.black) &
+                           enemyb);
 }
 
 }  // namespace abra
@@ -4,31 +4,86 @@
 #include <string>
 #include <vector>
 
+#include "evaluation.h"
+#include "material.h"
+#include "nnue.h"
+#include "pawns.h"
 #include "types.h"
 
 namespace abra {
 
+// state needed to take back a move, pushed by make_move
+struct undo_info {
+  uint64_t hash;
+  uint64_t pawn_hash;
+  uint64_t material_key;
+  int psq_score;
+  square en_passant;
+  int halfmove_cnt;
+  castle_rights castling;
+  move m;
+  piece captured;  // empty if no capture
+};
+
+// attacks of both sides and the king safety of the side to move, computed
+// by game on first use and kept until the position changes
+struct attack_info {
+  bitboard checkers;  // enemy pieces attacking the king of the side to move
+  bitboard pinned;    // pieces of the side to move pinned to its king
+  bitboard king_zone[2];  // each king's square and its neighbours
+  // squares attacked by each color (white, black) per piece type, pawn to
+  // king, and by_color their union, only valid for a color once
+  // has_maps[color] is set
+  bitboard by_type[2][6];
+  bitboard by_color[2];
+  bool has_checks;   // checkers, pinned and king_zone are valid
+  bool has_maps[2];  // by_type and by_color of white, black are valid
+};
+
 class game {
   board64 board;
   color color_to_move;
   castle_rights castling;
   square en_passant;
   int halfmove_cnt, fullmove;
+  uint64_t hash;  // zobrist key, updated incrementally by make_move
+  uint64_t pawn_hash;  // zobrist key of the pawns and kings only, same
+  // piece counts (see material::key_delta), the game phase follows from it
+  uint64_t material_key;
+  // material + piece-square score for white, midgame and endgame packed
+  // together (see evaluation::make_score), same as hash
+  int psq_score;
+  // optional network evaluation, its accumulator is pushed by make_move and
+  // popped by unmake_move like history
+  const nnue::network *net;
+  std::vector<nnue::accumulator> accumulators;
+  // one record per move made, its keys are the positions checked for
+  // repetitions
+  std::vector<undo_info> history;
+  // attack info of the position at every ply (history size), make_move
+  // clears the next ply's, unmake_move keeps the parent's
+  mutable std::vector<attack_info> attack_cache;
 
   // return a reference to the bitboard corresponding
   // to specified color
   const bitboard &get_colorb(color) const;
 
+  // update board, keys and psq_score together
+  void put_piece(square, piece);
+  void remove_piece(square);
+  void set_piece(square, piece);  // overwrites
+  void move_piece(square, square);  // captures if target is occupied
+
+  // take back the network accumulator with the move
+  void pop_accumulator();
+
   // helpers for make_move
   void handle_pawn_move(move, bool &, bool &);
   void handle_king_move(move);
   void handle_rook_move(move);
+  void handle_rook_capture(move);
 
-  // return list of all moves except castling for piece at square
-  // ignores ally capture or checks
-  bitboard get_moves(square) const;
-  // helpers
-  bitboard get_pawn_moves(bitboard, color) const;
+  // helpers to get attacks of a set of pieces
   bitboard get_pawn_attacks(bitboard, color) const;
   bitboard get_knight_moves(bitboard) const;
   bitboard get_bishop_moves(bitboard) const;
@@ -36,20 +91,24 @@ class game {
   bitboard get_queen_moves(bitboard) const;
   bitboard get_king_moves(bitboard) const;  // doesnt include castling
 
-  // return list of all pseudo legal moves for color
-  std::vector<move> get_moves(color) const;
+  // fill in the parts of the attack info, see get_attack_info
+  void compute_checks(attack_info &) const;
+  void compute_attack_maps(attack_info &, color) const;
 
-  // returns a bitboard containing all squares attacked by color
-  // pieces attacked by same color are considered attacked
-  bitboard get_attacks(color) const;
+  // forget the attack info of the position after a move
+  void clear_attack_info();
 
-  // returns true if any of squares are under attack by color
-  // helper for in_check & to check if you can castle
-  // calls: get_attacks
-  bool under_attack(const bitboard &, color) const;
+  // returns pieces of both colors attacking square, given occupied squares
+  bitboard attackers_to(square, bitboard) const;
+
+  // returns pieces of color which are pinned to their own king
+  bitboard get_pinned(color) const;
 
   bool is_material_insufficient() const;
 
+  // add the castling moves of the side to move, which must not be in check
+  void get_castling_moves(move_list &) const;
+
  public:
   // create new game with default start position
   game();
@@ -63,27 +122,110 @@ class game {
   // return the color which has to move now if game is not over
   color get_color_to_move() const;
 
+  // fill list with available (legal) moves, optionally only captures
+  void get_moves(move_list &, bool = false) const;
+
   // return list of available (legal) moves
+  // allocates, prefer the move_list version in hot code
   std::vector<move> get_moves(bool = false) const;
 
+  // fill list with pseudo legal moves, either captures and promotions
+  // (noisy) or the other moves, only evasions when in check
+  // a move may still leave the king attacked, see is_legal
+  void get_pseudo_moves(move_list &, bool noisy) const;
+
+  // true if the move could have been generated by get_pseudo_moves, for
+  // moves that come from elsewhere (transposition table, killers)
+  bool is_pseudo_legal(move) const;
+
+  // true if a pseudo legal move does not leave the king attacked
+  bool is_legal(move) const;
+
   // make a move and update state
   void make_move(move);
 
+  // pass the turn without moving, taken back by unmake_move
+  void make_null_move();
+
+  // take back the last move made
+  void unmake_move();
+
+  // number of moves that can be taken back
+  int get_ply() const;
+
+  // true if the last move made was a null move
+  bool is_after_null_move() const;
+
   // returns true iff game is over
   bool is_terminal() const;
 
+  // returns true if there is a legal move, stops at the first one found
+  bool has_legal_move() const;
+
+  // returns true if the game is drawn by rule (50 moves, insufficient
+  // material, or the position occurred n times before) even if moves are left
+  bool is_draw(int n = 2) const;
+
+  // returns true if the position occurred at least n times before, only
+  // positions since the last capture, pawn move or null move are compared
+  bool is_repetition(int n = 1) const;
+
   // returns the result of the game (should be terminal state)
   color get_result() const;
 
   // return true if color is in check
-  // calls under_attack
   bool in_check(color) const;
 
+  // checkers, pinned pieces and king zones of the position, movegen and
+  // check detection share them, computed at most once per position
+  const attack_info &get_attack_info() const;
+
+  // same, with the attack maps of color (pieces attacked by the same color
+  // are considered attacked)
+  const attack_info &get_attack_maps(color) const;
+
+  // return true if color has a piece other than pawns and the king
+  bool has_non_pawn_material(color) const;
+
   // returns piece at square
   piece piece_at(square) const;
 
-  // return a copy of the board
-  board64 get_board() const;
+  // return the board
+  const board64 &get_board() const;
+
+  // return zobrist key of the position
+  uint64_t get_hash() const;
+
+  // recompute zobrist key from scratch (for verification)
+  uint64_t compute_hash() const;
+
+  // return the key of the pawn table entry, see pawns::table
+  uint64_t get_pawn_hash() const;
+
+  // return the piece counts, the key of the material table entry
+  uint64_t get_material_key() const;
+
+  // recompute the piece counts from scratch (for verification)
+  uint64_t compute_material_key() const;
+
+  // recompute the pawn hash key from scratch (for verification)
+  uint64_t compute_pawn_hash() const;
+
+  // return material + piece-square score from white's perspective,
+  // tapered between midgame and endgame by the phase
+  int get_psq_score() const;
+
+  // recompute material + piece-square score from scratch (for verification)
+  int compute_psq_score() const;
+
+  // evaluate with a network from now on, nullptr for the piece-square score
+  // the network must outlive its use by this game
+  void set_network(const nnue::network *);
+
+  // static evaluation from white's perspective, by the network if set,
+  // otherwise the piece-square score plus the pawn structure and material
+  // terms cached in the tables
+  int evaluate(pawns::table &, material::table &) const;
 
   castle_rights get_castle_rights() const;
 
@@ -107,7 +249,35 @@ inline castle_rights game::get_castle_rights() const { return castling; }
 inline const bitboard &game::get_colorb(color c) const {
   return (c == color::white ? board.white : board.black);
 }
-inline board64 game::get_board() const { return board; }
+inline const board64 &game::get_board() const { return board; }
+inline const attack_info &game::get_attack_info() const {
+  auto &info = attack_cache[history.size()];
+  if (!info.has_checks) compute_checks(info);
+  return info;
+}
+inline const attack_info &game::get_attack_maps(color c) const {
+  auto &info = attack_cache[history.size()];
+  if (!info.has_checks) compute_checks(info);
+  if (!info.has_maps[c == color::white ? 0 : 1]) compute_attack_maps(info, c);
+  return info;
+}
+inline bool game::is_material_insufficient() const {
+  return material::is_insufficient(material_key);
+}
+inline bool game::has_non_pawn_material(color c) const {
+  return static_cast<bool>(get_colorb(c) & (board.knight | board.bishop |
+                                            board.rook | board.queen));
+}
+inline uint64_t game::get_hash() const { return hash; }
+inline uint64_t game::get_pawn_hash() const { return pawn_hash; }
+inline uint64_t game::get_material_key() const { return material_key; }
+inline int game::get_psq_score() const {
+  return evaluation::taper(psq_score, material::phase(material_key));
+}
+inline int game::get_ply() const { return static_cast<int>(history.size()); }
+inline bool game::is_after_null_move() const {
+  return !history.empty() && history.back().m == move{};
+}
 inline color game::get_color_to_move() const { return color_to_move; }
 inline piece game::piece_at(square i) const { return board.get_piece(i); }
 
@@ -4,13 +4,14 @@
 #include <string>
 #include <vector>
 
+#include "evaluation.h"
 #include "game.h"
 #include "notation.h"
 #include "types.h"
 
 namespace abra {
 
-game::game(const std::string& fen) : board{} {
+game::game(const std::string& fen) : board{}, net{nullptr} {
   auto tokens = notation::split_string(fen, ' ');
   if (tokens.size() != 6)
     throw new std::invalid_argument("fen '" + fen +
@@ -49,6 +50,16 @@ game::game(const std::string& fen) : board{} {
   halfmove_cnt = std::stoi(halfmove_clk);
   fullmove = std::stoi(fullmove_no);
 
+  hash = compute_hash();
+  pawn_hash = compute_pawn_hash();
+  material_key = compute_material_key();
+  psq_score = 0;
+  for (auto occupied = bitboard{board.white | board.black}; occupied;) {
+    auto i = pop_lsb(occupied);
+    psq_score += evaluation::psq_value(board.get_piece(i), i);
+  }
+
+  attack_cache.assign(1, attack_info{});
   if (in_check(get_opposite_color(color_to_move)))
     throw new std::invalid_argument(
         "fen '" + fen + "' has a king that can be captured immediately");
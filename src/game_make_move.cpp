@@ -1,29 +1,68 @@
+#include "evaluation.h"
 #include "game.h"
 #include "movement.h"
+#include "zobrist.h"
 
 namespace abra {
 
+void game::put_piece(square i, piece p) {
+  board.set_piece(i, p);
+  hash ^= zobrist::piece_key(p, i);
+  pawn_hash ^= zobrist::pawn_key(p, i);
+  psq_score += evaluation::psq_value(p, i);
+  material_key += material::key_delta(p);
+  if (net) nnue::add_piece(*net, board, p, i, accumulators.back());
+}
+
+void game::remove_piece(square i) {
+  auto p = board.get_piece(i);
+  if (p.is_empty()) return;
+  board.clear_piece(i);
+  hash ^= zobrist::piece_key(p, i);
+  pawn_hash ^= zobrist::pawn_key(p, i);
+  psq_score -= evaluation::psq_value(p, i);
+  material_key -= material::key_delta(p);
+  if (net) nnue::remove_piece(*net, board, p, i, accumulators.back());
+}
+
+void game::set_piece(square i, piece p) {
+  remove_piece(i);
+  put_piece(i, p);
+}
+
+void game::move_piece(square from, square to) {
+  auto p = board.get_piece(from);
+  remove_piece(to);
+  board.move_piece(from, to);
+  hash ^= zobrist::piece_key(p, from) ^ zobrist::piece_key(p, to);
+  pawn_hash ^= zobrist::pawn_key(p, from) ^ zobrist::pawn_key(p, to);
+  psq_score += evaluation::psq_value(p, to) - evaluation::psq_value(p, from);
+  if (net) {
+    nnue::remove_piece(*net, board, p, from, accumulators.back());
+    nnue::add_piece(*net, board, p, to, accumulators.back());
+  }
+}
+
 // handles special pawn moves
 void game::handle_pawn_move(move m, bool &capture, bool &reset_ep) {
   auto pawn_dir = movement::get_pawn_direction(color_to_move);
-  if (m.to == en_passant) {  // en passant
-    auto capture_on = m.to - pawn_dir;
-    board.clear_piece(capture_on);
+  if (m.flag() == move_flag::en_passant) {
+    auto capture_on = m.to() - pawn_dir;
+    remove_piece(capture_on);
     capture = true;
-  } else if (m.to == m.from + 2 * pawn_dir) {  // two step push
-    en_passant = m.from + pawn_dir;
+  } else if (m.to() == m.from() + 2 * pawn_dir) {  // two step push
+    en_passant = m.from() + pawn_dir;
     reset_ep = false;
-  } else if (!m.promotion.is_empty()) {  // promotion
-    board.set_piece(m.from, m.promotion);
+  } else if (m.flag() == move_flag::promotion) {
+    set_piece(m.from(), piece{color_to_move, m.promotion()});
   }
 }
 
 // handle special king moves & update castle flags
 void game::handle_king_move(move m) {
-  if (std::abs(m.to - m.from) == 2) {
-    // hack: only castling involves a two step king move
-    auto dir = (m.to - m.from) / 2;
-    square to = m.from, from = m.from;
+  if (m.flag() == move_flag::castling) {
+    auto dir = (m.to() - m.from()) / 2;
+    square to = m.from(), from = m.from();
     to += dir;
     if (dir > 0)  // king side
       from += 3;
@@ -31,8 +70,7 @@ void game::handle_king_move(move m) {
       from -= 4;
 
     // move the rook (king will be moved by make_move)
-    board.move_piece(from, to);
-    board.clear_piece(from);
+    move_piece(from, to);
   }
 
   // cannot castle now
@@ -45,7 +83,7 @@ void game::handle_king_move(move m) {
 // update castle flags if rook move
 void game::handle_rook_move(move m) {
   auto first_row = color_to_move == color::white ? 7 : 0;
-  int r = get_row(m.from), c = get_col(m.from);
+  int r = get_row(m.from()), c = get_col(m.from());
   if (c == 0 && r == first_row) {
     auto &cflag = (color_to_move == color::white ? castling.white_long
                                                  : castling.black_long);
@@ -57,13 +95,38 @@ void game::handle_rook_move(move m) {
   }
 }
 
+// update opponent castle flags if a rook is captured on its initial square
+void game::handle_rook_capture(move m) {
+  auto first_row = color_to_move == color::white ? 0 : 7;
+  int r = get_row(m.to()), c = get_col(m.to());
+  if (c == 0 && r == first_row) {
+    auto &cflag = (color_to_move == color::white ? castling.black_long
+                                                 : castling.white_long);
+    cflag = false;
+  } else if (c == 7 && r == first_row) {
+    auto &cflag = (color_to_move == color::white ? castling.black_short
+                                                 : castling.white_short);
+    cflag = false;
+  }
+}
+
 // make a move
 void game::make_move(move m) {
-  auto _piece = board.get_piece(m.from);
+  auto _piece = board.get_piece(m.from());
+  auto captured = board.get_piece(m.to());
+  if (m.flag() == move_flag::en_passant)
+    captured = piece{get_opposite_color(color_to_move), piece_type::pawn};
+  history.push_back(
+      undo_info{hash, pawn_hash, material_key, psq_score, en_passant,
+                halfmove_cnt, castling, m, captured});
+  clear_attack_info();
+  if (net) accumulators.push_back(accumulators.back());
 
   // flags to update state
-  auto reset_ep = true, pawn_move = false,
-       capture = !board.get_piece(m.to).is_empty();
+  auto reset_ep = true, pawn_move = false, capture = !captured.is_empty();
+
+  // castling and en passant keys are swapped out wholesale
+  hash ^= zobrist::castling_key(castling) ^ zobrist::en_passant_key(en_passant);
 
   // handle special moves
   if (_piece.ptype == piece_type::pawn) {
@@ -74,10 +137,13 @@ void game::make_move(move m) {
   } else if (_piece.ptype == piece_type::rook) {
     handle_rook_move(m);
   }
+  if (capture) handle_rook_capture(m);
 
   // move piece
-  board.move_piece(m.from, m.to);
-  board.clear_piece(m.from);
+  move_piece(m.from(), m.to());
+  // every feature of the mover's side depends on its king square
+  if (net && _piece.ptype == piece_type::king)
+    nnue::refresh(*net, board, color_to_move, accumulators.back());
 
   // update other states
   color_to_move = get_opposite_color(color_to_move);
@@ -87,6 +153,102 @@ void game::make_move(move m) {
     halfmove_cnt++;
   else
     halfmove_cnt = 0;
+
+  hash ^= zobrist::castling_key(castling) ^ zobrist::en_passant_key(en_passant);
+  hash ^= zobrist::keys.black_to_move;
+
+  assert(hash == compute_hash());
+  assert(pawn_hash == compute_pawn_hash());
+  assert(material_key == compute_material_key());
+  assert(get_psq_score() == compute_psq_score());
+}
+
+// the accumulator from before the move, or a fresh one if the network was
+// set after the move was made
+void game::pop_accumulator() {
+  if (accumulators.size() > 1) {
+    accumulators.pop_back();
+    return;
+  }
+  for (auto c : {color::white, color::black})
+    nnue::refresh(*net, board, c, accumulators.back());
+}
+
+// the attack info of the new position is computed again on first use, the
+// cache only grows so that taking moves back keeps every parent's
+void game::clear_attack_info() {
+  auto ply = history.size();
+  if (attack_cache.size() <= ply) attack_cache.resize(ply + 1);
+  auto &info = attack_cache[ply];
+  info.has_checks = info.has_maps[0] = info.has_maps[1] = false;
+}
+
+// null move, recorded as move{} so that unmake_move only restores the state
+void game::make_null_move() {
+  history.push_back(undo_info{hash, pawn_hash, material_key, psq_score,
+                              en_passant, halfmove_cnt, castling, move{},
+                              piece{}});
+  clear_attack_info();
+  if (net) accumulators.push_back(accumulators.back());
+  hash ^= zobrist::en_passant_key(en_passant) ^ zobrist::keys.black_to_move;
+  en_passant = null_square;
+  hash ^= zobrist::en_passant_key(en_passant);
+  color_to_move = get_opposite_color(color_to_move);
+  if (color_to_move == color::white) fullmove++;
+  halfmove_cnt++;
+  assert(hash == compute_hash());
+}
+
+// take back the last move, the board is restored piece by piece and the
+// rest of the state is copied back from the undo record
+void game::unmake_move() {
+  assert(!history.empty());
+  auto &u = history.back();
+  auto m = u.m;
+
+  color_to_move = get_opposite_color(color_to_move);
+  if (color_to_move == color::black) fullmove--;
+
+  if (m == move{}) {  // null move, the board did not change
+    hash = u.hash;
+    en_passant = u.en_passant;
+    halfmove_cnt = u.halfmove_cnt;
+    history.pop_back();
+    if (net) pop_accumulator();
+    return;
+  }
+
+  board.move_piece(m.to(), m.from());
+  if (m.flag() == move_flag::promotion)
+    board.set_piece(m.from(), piece{color_to_move, piece_type::pawn});
+
+  if (!u.captured.is_empty()) {
+    auto capture_on = m.to();
+    if (m.flag() == move_flag::en_passant)
+      capture_on -= movement::get_pawn_direction(color_to_move);
+    board.set_piece(capture_on, u.captured);
+  }
+
+  if (m.flag() == move_flag::castling) {
+    // put the castled rook back in its corner
+    auto dir = (m.to() - m.from()) / 2;
+    square from = m.from() + dir, to = m.from() + (dir > 0 ? 3 : -4);
+    board.move_piece(from, to);
+  }
+
+  hash = u.hash;
+  pawn_hash = u.pawn_hash;
+  psq_score = u.psq_score;
+  material_key = u.material_key;
+  en_passant = u.en_passant;
+  halfmove_cnt = u.halfmove_cnt;
+  castling = u.castling;
+  history.pop_back();
+  if (net) pop_accumulator();
+  assert(hash == compute_hash());
+  assert(pawn_hash == compute_pawn_hash());
+  assert(material_key == compute_material_key());
+  assert(get_psq_score() == compute_psq_score());
 }
 
 }  // namespace abra
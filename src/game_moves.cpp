@@ -1,95 +1,363 @@
+#include <algorithm>
+
+#include "attacks.h"
 #include "game.h"
 #include "movement.h"
 
 namespace abra {
 
-bitboard game::get_attacks(color c) const {
-  auto attacks = bitboard{0};
+void game::compute_checks(attack_info &info) const {
+  auto us = color_to_move;
+  square king_sq = lsb(get_colorb(us) & board.king);
+  info.checkers = attackers_to(king_sq, board.white | board.black) &
+                  get_colorb(get_opposite_color(us));
+  info.pinned = get_pinned(us);
+  for (auto c : {color::white, color::black}) {
+    square s = lsb(get_colorb(c) & board.king);
+    info.king_zone[c == color::white ? 0 : 1] =
+        attacks::king_attacks(s) | to_bitboard(s);
+  }
+  info.has_checks = true;
+}
+
+void game::compute_attack_maps(attack_info &info, color c) const {
+  auto i = (c == color::white ? 0 : 1);
   auto &colorb = get_colorb(c);
-  attacks |= get_pawn_attacks(colorb & board.pawn, c);
-  attacks |= get_knight_moves(colorb & board.knight);
-  attacks |= get_bishop_moves(colorb & (board.bishop | board.queen));
-  attacks |= get_rook_moves(colorb & (board.rook | board.queen));
-  // queen attacks are covered
-  attacks |= get_king_moves(colorb & board.king);
-  return attacks;
+  auto &by_type = info.by_type[i];
+  by_type[0] = get_pawn_attacks(colorb & board.pawn, c);
+  by_type[1] = get_knight_moves(colorb & board.knight);
+  by_type[2] = get_bishop_moves(colorb & board.bishop);
+  by_type[3] = get_rook_moves(colorb & board.rook);
+  by_type[4] = get_queen_moves(colorb & board.queen);
+  by_type[5] = get_king_moves(colorb & board.king);
+  info.by_color[i] = 0;
+  for (auto b : by_type) info.by_color[i] |= b;
+  info.has_maps[i] = true;
 }
 
-bool game::under_attack(const bitboard &squares, color c) const {
-  return static_cast<bool>(squares & get_attacks(c));
+bitboard game::attackers_to(square i, bitboard occupied) const {
+  using namespace attacks;
+  // a pawn attacks i iff a pawn of the other color on i would attack it
+  return (pawn_attacks(color::white, i) & board.black & board.pawn) |
+         (pawn_attacks(color::black, i) & board.white & board.pawn) |
+         (knight_attacks(i) & board.knight) | (king_attacks(i) & board.king) |
+         (bishop_attacks(i, occupied) & (board.bishop | board.queen)) |
+         (rook_attacks(i, occupied) & (board.rook | board.queen));
 }
 
-// return list of all pseudo legal moves for piece at square
-bitboard game::get_moves(square i) const {
-  auto x = board.get_piece(i);
-  auto b = to_bitboard(i);
-  switch (x.ptype) {
-    case piece_type::pawn:
-      return get_pawn_moves(b, x.pcolor);
-    case piece_type::knight:
-      return get_knight_moves(b);
-    case piece_type::bishop:
-      return get_bishop_moves(b);
-    case piece_type::rook:
-      return get_rook_moves(b);
-    case piece_type::queen:
-      return get_queen_moves(b);
-    case piece_type::king:
-      return get_king_moves(b);
-    case piece_type::empty:;
+bitboard game::get_pinned(color c) const {
+  auto &colorb = get_colorb(c), &enemyb = get_colorb(get_opposite_color(c));
+  auto occupied = bitboard{board.black | board.white};
+  square king_sq = lsb(colorb & board.king);
+
+  // enemy sliders which would attack the king on an empty board
+  auto snipers =
+      (attacks::bishop_attacks(king_sq, 0) & (board.bishop | board.queen)) |
+      (attacks::rook_attacks(king_sq, 0) & (board.rook | board.queen));
+  snipers &= enemyb;
+
+  auto pinned = bitboard{0};
+  while (snipers) {
+    auto blockers = attacks::between(king_sq, pop_lsb(snipers)) & occupied;
+    // exactly one piece in between, and it is ours
+    if (blockers && !more_than_one(blockers)) pinned |= blockers & colorb;
   }
-  assert(false);
+  return pinned;
 }
 
-// return list of all pseudo legal moves for color
-std::vector<move> game::get_moves(color c) const {
-  const static auto pawn_promotions =
-      std::vector<piece_type>{piece_type::knight, piece_type::bishop,
-                              piece_type::rook, piece_type::queen};
-  auto moves = std::vector<move>{};
-  moves.reserve(32);
-  auto &colorb = get_colorb(c);
-  auto last_row = (c == color::white ? 0 : 7);
-  for (square i = 0; i < 64; i++) {
-    if (!test_bit(colorb, i)) continue;
-    auto mvb = get_moves(i);
-    mvb &= ~colorb;  // remove ally capture if any
-    for (square p = 0; p < 64; p++) {
-      if (test_bit(mvb, p)) {
-        if (get_row(p) == last_row && test_bit(board.pawn, i)) {
-          // pawn to last row (final rank)
-          for (auto promote : pawn_promotions)
-            moves.emplace_back(i, p, piece{c, promote});
-        } else {
-          moves.emplace_back(i, p);
-        }
+std::vector<move> game::get_moves(bool captures_only) const {
+  auto moves = move_list{};
+  get_moves(moves, captures_only);
+  return std::vector<move>(moves.begin(), moves.end());
+}
+
+// fill list with legal moves, the checkers and pinned pieces come from the
+// attack info and every generated move is legal without making it
+void game::get_moves(move_list &moves, bool captures_only) const {
+  const static piece_type pawn_promotions[] = {
+      piece_type::knight, piece_type::bishop, piece_type::rook,
+      piece_type::queen};
+
+  auto us = color_to_move, them = get_opposite_color(us);
+  auto &colorb = get_colorb(us), &enemyb = get_colorb(them);
+  auto occupied = bitboard{colorb | enemyb};
+  square king_sq = lsb(colorb & board.king);
+  auto &info = get_attack_info();
+  auto checkers = info.checkers, pinned = info.pinned;
+
+  auto add_moves = [&](square from, bitboard targets) {
+    while (targets) moves.emplace_back(from, pop_lsb(targets));
+  };
+
+  // the king may not step along the line of a checking slider, so it is
+  // removed from the occupancy when testing its targets
+  auto king_targets = attacks::king_attacks(king_sq) & ~colorb;
+  if (captures_only) king_targets &= enemyb;
+  auto occupied_no_king = occupied ^ to_bitboard(king_sq);
+  while (king_targets) {
+    auto to = pop_lsb(king_targets);
+    if (!(attackers_to(to, occupied_no_king) & enemyb))
+      moves.emplace_back(king_sq, to);
+  }
+
+  // double check, only king moves
+  if (more_than_one(checkers)) return;
+
+  // in check, capture the checker or block
+  auto target = ~colorb;
+  if (checkers)
+    target = attacks::between(king_sq, lsb(checkers)) | checkers;
+  if (captures_only) target &= enemyb;
+
+  auto pieces = bitboard{colorb & ~(board.pawn | board.king)};
+  while (pieces) {
+    auto from = pop_lsb(pieces);
+    auto mvb = bitboard{0};
+    if (test_bit(board.knight, from))
+      mvb = attacks::knight_attacks(from);
+    else if (test_bit(board.bishop, from))
+      mvb = attacks::bishop_attacks(from, occupied);
+    else if (test_bit(board.rook, from))
+      mvb = attacks::rook_attacks(from, occupied);
+    else
+      mvb = attacks::queen_attacks(from, occupied);
+    mvb &= target;
+    // a pinned piece may only move along the pin
+    if (test_bit(pinned, from)) mvb &= attacks::line(king_sq, from);
+    add_moves(from, mvb);
+  }
+
+  auto pawn_dir = movement::get_pawn_direction(us);
+  auto start_row = (us == color::white ? 6 : 1);
+  auto last_row = (us == color::white ? 0 : 7);
+  auto pawns = bitboard{colorb & board.pawn};
+  while (pawns) {
+    auto from = pop_lsb(pawns);
+    auto mvb = attacks::pawn_attacks(us, from) & enemyb;
+    square one = from + pawn_dir;
+    if (!test_bit(occupied, one)) {
+      set_bit(mvb, one);
+      if (get_row(from) == start_row && !test_bit(occupied, one + pawn_dir))
+        set_bit(mvb, one + pawn_dir);
+    }
+    mvb &= target;
+    if (test_bit(pinned, from)) mvb &= attacks::line(king_sq, from);
+    while (mvb) {
+      auto to = pop_lsb(mvb);
+      if (get_row(to) == last_row) {
+        for (auto promote : pawn_promotions)
+          moves.emplace_back(from, to, move_flag::promotion, promote);
+      } else {
+        moves.emplace_back(from, to);
       }
     }
+
+    // en passant removes two pieces from a line, so test the king directly
+    // this also covers pinned pawns and capturing a checking pawn
+    if (is_valid_square(en_passant) &&
+        test_bit(attacks::pawn_attacks(us, from), en_passant)) {
+      square captured = en_passant - pawn_dir;
+      auto after = (occupied ^ to_bitboard(from) ^ to_bitboard(captured)) |
+                   to_bitboard(en_passant);
+      if (!(attackers_to(king_sq, after) & enemyb & ~to_bitboard(captured)))
+        moves.emplace_back(from, en_passant, move_flag::en_passant);
+    }
   }
-  // add castling explicitly
-  auto attacks = get_attacks(get_opposite_color(c));
-  auto [sc, lc] = castling.get_castle_rights(c);
-  auto king_sq = (c == color::white ? 60 : 4);
-  if (!(sc || lc) || test_bit(attacks, king_sq)) return moves;
-  auto occupied = bitboard{board.black | board.white};
 
-  auto add_castling = [&](const bitboard &safe, const bitboard &empty,
-                          square dir) {
-    if (attacks & safe) return;
+  if (!checkers && !captures_only) get_castling_moves(moves);
+}
+
+void game::get_castling_moves(move_list &moves) const {
+  auto us = color_to_move;
+  auto [sc, lc] = castling.get_castle_rights(us);
+  if (!(sc || lc)) return;
+
+  auto them = get_opposite_color(us);
+  auto occupied = bitboard{board.white | board.black};
+  square king_sq = lsb(get_colorb(us) & board.king);
+  auto add_castling = [&](square dir, const bitboard &empty) {
     if (occupied & empty) return;
-    moves.emplace_back(king_sq, king_sq + 2 * dir);
+    // the king may not pass through or land on an attacked square
+    auto path = to_bitboard(king_sq + dir) | to_bitboard(king_sq + 2 * dir);
+    if (path & get_attack_maps(them).by_color[them == color::white ? 0 : 1])
+      return;
+    moves.emplace_back(king_sq, king_sq + 2 * dir, move_flag::castling);
   };
 
-  if (sc)
-    add_castling(to_bitboard(king_sq + 1) | to_bitboard(king_sq + 2),
-                 to_bitboard(king_sq + 1) | to_bitboard(king_sq + 2), 1);
+  if (sc) add_castling(1, to_bitboard(king_sq + 1) | to_bitboard(king_sq + 2));
   if (lc)
-    add_castling(to_bitboard(king_sq - 1) | to_bitboard(king_sq - 2),
-                 to_bitboard(king_sq - 1) | to_bitboard(king_sq - 2) |
-                     to_bitboard(king_sq - 3),
-                 -1);
+    add_castling(-1, to_bitboard(king_sq - 1) | to_bitboard(king_sq - 2) |
+                         to_bitboard(king_sq - 3));
+}
+
+// like get_moves without the pin and king safety tests, which are left to
+// is_legal so that moves which are never searched are never tested
+void game::get_pseudo_moves(move_list &moves, bool noisy) const {
+  const static piece_type pawn_promotions[] = {
+      piece_type::knight, piece_type::bishop, piece_type::rook,
+      piece_type::queen};
+
+  auto us = color_to_move, them = get_opposite_color(us);
+  auto &colorb = get_colorb(us), &enemyb = get_colorb(them);
+  auto occupied = bitboard{colorb | enemyb};
+  square king_sq = lsb(colorb & board.king);
+  auto checkers = get_attack_info().checkers;
+
+  auto add_moves = [&](square from, bitboard targets) {
+    while (targets) moves.emplace_back(from, pop_lsb(targets));
+  };
+
+  auto target = (noisy ? enemyb : ~occupied);
+  add_moves(king_sq, attacks::king_attacks(king_sq) & target);
+  if (more_than_one(checkers)) return;
+
+  // in check, capture the checker or block
+  auto evasions = ~bitboard{0};
+  if (checkers) evasions = attacks::between(king_sq, lsb(checkers)) | checkers;
+  target &= evasions;
+
+  auto pieces = bitboard{colorb & ~(board.pawn | board.king)};
+  while (pieces) {
+    auto from = pop_lsb(pieces);
+    auto mvb = bitboard{0};
+    if (test_bit(board.knight, from))
+      mvb = attacks::knight_attacks(from);
+    else if (test_bit(board.bishop, from))
+      mvb = attacks::bishop_attacks(from, occupied);
+    else if (test_bit(board.rook, from))
+      mvb = attacks::rook_attacks(from, occupied);
+    else
+      mvb = attacks::queen_attacks(from, occupied);
+    add_moves(from, mvb & target);
+  }
+
+  // pushes to the last row are promotions, which are noisy
+  auto pawn_dir = movement::get_pawn_direction(us);
+  auto start_row = (us == color::white ? 6 : 1);
+  auto last_row = (us == color::white ? 0 : 7);
+  auto promotion_squares = bitboard{0xff} << (8 * last_row);
+  auto pawns = bitboard{colorb & board.pawn};
+  while (pawns) {
+    auto from = pop_lsb(pawns);
+    auto pushes = bitboard{0};
+    square one = from + pawn_dir;
+    if (!test_bit(occupied, one)) {
+      set_bit(pushes, one);
+      if (get_row(from) == start_row && !test_bit(occupied, one + pawn_dir))
+        set_bit(pushes, one + pawn_dir);
+    }
+    auto mvb = (noisy ? (attacks::pawn_attacks(us, from) & enemyb) |
+                            (pushes & promotion_squares)
+                      : pushes & ~promotion_squares);
+    mvb &= evasions;
+    while (mvb) {
+      auto to = pop_lsb(mvb);
+      if (get_row(to) == last_row) {
+        for (auto promote : pawn_promotions)
+          moves.emplace_back(from, to, move_flag::promotion, promote);
+      } else {
+        moves.emplace_back(from, to);
+      }
+    }
+
+    if (noisy && is_valid_square(en_passant) &&
+        test_bit(attacks::pawn_attacks(us, from), en_passant))
+      moves.emplace_back(from, en_passant, move_flag::en_passant);
+  }
+
+  if (!noisy && !checkers) get_castling_moves(moves);
+}
+
+bool game::is_pseudo_legal(move m) const {
+  auto us = color_to_move, them = get_opposite_color(us);
+  auto &colorb = get_colorb(us), &enemyb = get_colorb(them);
+  auto occupied = bitboard{colorb | enemyb};
+  auto from = m.from(), to = m.to();
+  auto p = board.get_piece(from);
+  // this also rejects move{}, which starts and ends on the same square
+  if (p.pcolor != us || test_bit(colorb, to)) return false;
+
+  square king_sq = lsb(colorb & board.king);
+  auto checkers = get_attack_info().checkers;
+  if (m.flag() == move_flag::castling) {
+    if (checkers) return false;
+    auto moves = move_list{};
+    get_castling_moves(moves);
+    return std::find(moves.begin(), moves.end(), m) != moves.end();
+  }
+
+  if (p.ptype == piece_type::pawn) {
+    auto pawn_dir = movement::get_pawn_direction(us);
+    // is_legal tests what en passant does to the king
+    if (m.flag() == move_flag::en_passant)
+      return to == en_passant &&
+             test_bit(attacks::pawn_attacks(us, from), to);
+    auto last_row = (us == color::white ? 0 : 7);
+    auto start_row = (us == color::white ? 6 : 1);
+    if ((get_row(to) == last_row) != (m.flag() == move_flag::promotion))
+      return false;
+    auto capture =
+        test_bit(attacks::pawn_attacks(us, from), to) && test_bit(enemyb, to);
+    auto push = (to == from + pawn_dir && !test_bit(occupied, to));
+    auto double_push =
+        (to == from + 2 * pawn_dir && get_row(from) == start_row &&
+         !test_bit(occupied, from + pawn_dir) && !test_bit(occupied, to));
+    if (!capture && !push && !double_push) return false;
+  } else {
+    if (m.flag() != move_flag::normal) return false;
+    auto mvb = bitboard{0};
+    switch (p.ptype) {
+      case piece_type::knight:
+        mvb = attacks::knight_attacks(from);
+        break;
+      case piece_type::bishop:
+        mvb = attacks::bishop_attacks(from, occupied);
+        break;
+      case piece_type::rook:
+        mvb = attacks::rook_attacks(from, occupied);
+        break;
+      case piece_type::queen:
+        mvb = attacks::queen_attacks(from, occupied);
+        break;
+      default:
+        mvb = attacks::king_attacks(from);
+    }
+    if (!test_bit(mvb, to)) return false;
+  }
+
+  // same evasions as get_pseudo_moves, king moves are left to is_legal
+  if (checkers && p.ptype != piece_type::king) {
+    if (more_than_one(checkers)) return false;
+    if (!test_bit(attacks::between(king_sq, lsb(checkers)) | checkers, to))
+      return false;
+  }
+  return true;
+}
+
+bool game::is_legal(move m) const {
+  auto us = color_to_move;
+  auto &colorb = get_colorb(us), &enemyb = get_colorb(get_opposite_color(us));
+  auto occupied = bitboard{colorb | enemyb};
+  auto from = m.from(), to = m.to();
+  square king_sq = lsb(colorb & board.king);
+
+  // castling is only generated when the king's path is safe
+  if (m.flag() == move_flag::castling) return true;
+
+  // en passant removes two pieces from a line, so test the king directly
+  if (m.flag() == move_flag::en_passant) {
+    square captured = en_passant - movement::get_pawn_direction(us);
+    auto after = (occupied ^ to_bitboard(from) ^ to_bitboard(captured)) |
+                 to_bitboard(en_passant);
+    return !(attackers_to(king_sq, after) & enemyb & ~to_bitboard(captured));
+  }
+
+  if (from == king_sq)
+    return !(attackers_to(to, occupied ^ to_bitboard(from)) & enemyb);
 
-  return moves;
+  // a pinned piece may only move along the line through its king
+  return !test_bit(get_attack_info().pinned, from) ||
+         test_bit(attacks::line(king_sq, from), to);
 }
 
 }  // namespace abra
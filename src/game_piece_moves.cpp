@@ -1,3 +1,4 @@
+#include "attacks.h"
 #include "game.h"
 #include "movement.h"
 
@@ -41,22 +42,6 @@ bitboard game::get_pawn_attacks(bitboard b, color c) const {
   return moves;
 }
 
-bitboard game::get_pawn_moves(bitboard b, color c) const {
-  auto vacant = ~bitboard{board.black | board.white};
-  auto moves = get_pawn_attacks(b, c) & (~vacant | to_bitboard(en_passant));
-  auto pawn_dir = get_pawn_direction(c);
-  auto &start_rowb = (c == color::white) ? row6 : row1;
-
-  // one step push
-  moves |= shift_board(b, pawn_dir) & vacant;
-
-  // two step push
-  auto ps1 = shift_board(b & start_rowb, pawn_dir) & vacant;
-  moves |= shift_board(ps1, pawn_dir) & vacant;
-
-  return moves;
-}
-
 // short range pieces
 
 bitboard game::get_knight_moves(bitboard b) const {
@@ -85,38 +70,27 @@ bitboard game::get_king_moves(bitboard b) const {
   return moves;
 }
 
-// sliding pieces
-
-inline auto get_slide_moves(const bitboard &pieces, bitboard vacant,
-                            bitboard invalid, square dir) {
-  auto moves = shift_board(pieces & ~invalid, dir);
-  vacant &= ~invalid;
-  for (int i = 0; i < 6; i++) moves |= shift_board(moves & vacant, dir);
-  return moves;
-}
+// sliding pieces (table lookups, see attacks.h)
 
 bitboard game::get_bishop_moves(bitboard b) const {
-  auto vacant = ~bitboard{board.black | board.white};
+  auto occupied = bitboard{board.black | board.white};
   auto moves = bitboard{0};
-  moves |= get_slide_moves(b, vacant, row0 | col0, up + left);
-  moves |= get_slide_moves(b, vacant, row0 | col7, up + right);
-  moves |= get_slide_moves(b, vacant, row7 | col0, down + left);
-  moves |= get_slide_moves(b, vacant, row7 | col7, down + right);
+  while (b) moves |= attacks::bishop_attacks(pop_lsb(b), occupied);
   return moves;
 }
 
 bitboard game::get_rook_moves(bitboard b) const {
-  auto vacant = ~bitboard{board.black | board.white};
+  auto occupied = bitboard{board.black | board.white};
   auto moves = bitboard{0};
-  moves |= get_slide_moves(b, vacant, row0, up);
-  moves |= get_slide_moves(b, vacant, row7, down);
-  moves |= get_slide_moves(b, vacant, col0, left);
-  moves |= get_slide_moves(b, vacant, col7, right);
+  while (b) moves |= attacks::rook_attacks(pop_lsb(b), occupied);
   return moves;
 }
 
 bitboard game::get_queen_moves(bitboard b) const {
-  return bitboard{get_bishop_moves(b) | get_rook_moves(b)};
+  auto occupied = bitboard{board.black | board.white};
+  auto moves = bitboard{0};
+  while (b) moves |= attacks::queen_attacks(pop_lsb(b), occupied);
+  return moves;
 }
 
 }  // namespace abra
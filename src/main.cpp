@@ -3,11 +3,14 @@
 #include <exception>
 #include <iostream>
 
+#include "attacks.h"
 #include "display.h"
 #include "game.h"
+#include "nnue.h"
 #include "notation.h"
 #include "search.h"
 #include "types.h"
+#include "uci.h"
 
 using namespace abra;
 using std::cin;
@@ -18,6 +21,9 @@ struct bot_config {
   int max_search_time_ms;
   std::string position;
   std::string policy;
+  size_t hash_mb;
+  bool uci;
+  std::string nnue;
 };
 
 // the game loop
@@ -32,7 +38,9 @@ void play_game(strategy& strat, bot_config& config) {
   while (!g.is_terminal()) {
     if (g.get_color_to_move() == us) {
       auto begin = steady_clock::now();
-      auto [sc, _move] = strat.choose_move(g, config.max_search_time_ms);
+      auto limits = search_limits{};
+      limits.movetime = config.max_search_time_ms;
+      auto [sc, _move] = strat.choose_move(g, limits);
       auto end = steady_clock::now();
       cout << "BOT: " << notation::to_AN(_move) << "  " << (sc > 0 ? "+" : "")
            << sc << " ("
@@ -50,12 +58,17 @@ void play_game(strategy& strat, bot_config& config) {
       }
       auto moves = g.get_moves();
       try {
+        // castling and en passant flags are only known to the generator,
+        // so match on notation and play the generated move
         auto mv = notation::to_move(their_move);
-        if (std::find(moves.begin(), moves.end(), mv) == moves.end()) {
+        auto it = std::find_if(moves.begin(), moves.end(), [&](move m) {
+          return notation::to_AN(m) == notation::to_AN(mv);
+        });
+        if (it == moves.end()) {
           cout << "illegal!" << std::endl;
           continue;
         }
-        g.make_move(mv);
+        g.make_move(*it);
       } catch (std::invalid_argument* err) {
         cout << "ERROR: " << err->what() << std::endl;
         continue;
@@ -74,11 +87,17 @@ void play_game(strategy& strat, bot_config& config) {
 }
 
 int main(int argc, const char* argv[]) {
+  attacks::init();
   try {
-    auto config = bot_config{color::white, 10000, "", ""};
+    auto config = bot_config{color::white, 10000, "", "", 16, false, ""};
     // parse fen
     for (int i = 1; i < argc; i += 2) {
       auto flg = std::string{argv[i]};
+      if (flg == "--uci") {  // the only flag without a value
+        config.uci = true;
+        i--;
+        continue;
+      }
       if (i + 1 >= argc)
         throw new std::invalid_argument(flg + " does not have a value");
       auto val = std::string{argv[i + 1]};
@@ -91,6 +110,10 @@ int main(int argc, const char* argv[]) {
           throw new std::invalid_argument("invalid color " + val);
       } else if (flg == "--think") {
         config.max_search_time_ms = std::stoi(val);
+      } else if (flg == "--hash") {
+        config.hash_mb = std::stoul(val);
+      } else if (flg == "--nnue") {
+        config.nnue = val;
       } else if (flg == "--fen") {
         config.position = std::string{val};
       } else if (flg == "--strategy") {
@@ -102,11 +125,14 @@ int main(int argc, const char* argv[]) {
         throw new std::invalid_argument("invalid arguement " + flg);
       }
     }
-    if (config.policy.empty()) {
+    if (config.uci) {
+      uci::loop(config.hash_mb, config.nnue);
+    } else if (config.policy.empty()) {
       auto strat = strategy{};
       play_game(strat, config);
     } else {
-      auto strat = minimax_search{};
+      auto strat = minimax_search{config.hash_mb};
+      if (!config.nnue.empty()) strat.set_network(nnue::load(config.nnue));
       play_game(strat, config);
     }
 
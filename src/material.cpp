@@ -0,0 +1,88 @@
+#include "material.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "evaluation.h"
+
+namespace abra::material {
+
+namespace {
+
+const int bishop_pair = evaluation::make_score(30, 50);
+
+// spreads the count fields over the index bits
+const uint64_t index_multiplier = 0x9e3779b97f4a7c15;
+
+int non_pawn_material(uint64_t key, color c) {
+  auto value = 0;
+  for (auto t : {piece_type::knight, piece_type::bishop, piece_type::rook,
+                 piece_type::queen})
+    value += evaluation::pv_mg[static_cast<int>(t) - 1] * count(key, c, t);
+  return value;
+}
+
+// a side without pawns cannot win if it is up by no more than a minor
+// piece (rook against bishop, rook and knight against rook...) or only has
+// two knights
+int scale_factor(uint64_t key, color c) {
+  if (count(key, c, piece_type::pawn) > 0) return full_scale;
+  auto us = non_pawn_material(key, c),
+       them = non_pawn_material(key, get_opposite_color(c));
+  auto knights = count(key, c, piece_type::knight);
+  if (us - them <= evaluation::pv_mg[2] ||
+      (knights == 2 && us == 2 * evaluation::pv_mg[1]))
+    return drawish_scale;
+  return full_scale;
+}
+
+}  // namespace
+
+int phase(uint64_t key) {
+  auto value = 0;
+  for (auto c : {color::white, color::black})
+    for (int t = 1; t <= 5; t++)
+      value += evaluation::phase_weight[t - 1] *
+               count(key, c, static_cast<piece_type>(t));
+  return std::min(value, evaluation::max_phase);
+}
+
+entry evaluate(uint64_t key) {
+  auto e = entry{key, 0, 0, is_insufficient(key), false, {0, 0}};
+  e.phase = static_cast<uint8_t>(phase(key));
+  for (auto c : {color::white, color::black})
+    if (count(key, c, piece_type::bishop) >= 2)
+      e.score += (c == color::white ? bishop_pair : -bishop_pair);
+  if (!e.insufficient) {
+    e.scale[0] = static_cast<uint8_t>(scale_factor(key, color::white));
+    e.scale[1] = static_cast<uint8_t>(scale_factor(key, color::black));
+  }
+  e.drawish = (e.scale[0] < full_scale && e.scale[1] < full_scale);
+  return e;
+}
+
+table::table(size_t size)
+    : entries(size), shift{64}, probes{0}, hits{0} {
+  assert(size > 1 && (size & (size - 1)) == 0);
+  for (; size > 1; size >>= 1) shift--;
+  clear();
+}
+
+const entry &table::probe(uint64_t key) {
+  auto &e = entries[(key * index_multiplier) >> shift];
+  probes++;
+  if (e.key == key) {
+    hits++;
+    return e;
+  }
+  e = evaluate(key);
+  return e;
+}
+
+// empty entries hold the bare kings (key 0), so they are never wrong
+void table::clear() {
+  std::fill(entries.begin(), entries.end(), evaluate(0));
+  probes = hits = 0;
+}
+
+}  // namespace abra::material
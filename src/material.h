@@ -0,0 +1,85 @@
+#ifndef ABRA_MATERIAL_H
+#define ABRA_MATERIAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+// material signature evaluation, see
+// https://www.chessprogramming.org/Material_Hash_Table
+namespace abra::material {
+
+// the material key holds the number of pieces of every color and type
+// (kings excluded) in 4 bit fields, white pawn to queen then black, so it
+// is updated by adding or subtracting one piece's delta
+inline uint64_t key_delta(piece p) {
+  if (p.ptype == piece_type::king) return 0;
+  auto field = (static_cast<int>(p.pcolor) - 1) * 5 +
+               static_cast<int>(p.ptype) - 1;
+  return uint64_t{1} << (4 * field);
+}
+
+inline int count(uint64_t key, color c, piece_type t) {
+  auto field = (static_cast<int>(c) - 1) * 5 + static_cast<int>(t) - 1;
+  return static_cast<int>((key >> (4 * field)) & 15);
+}
+
+// neither side can mate: no pawns, rooks or queens and at most one minor
+// piece each
+inline bool is_insufficient(uint64_t key) {
+  constexpr auto minors = uint64_t{0xff} << 4 | uint64_t{0xff} << 24;
+  if (key & ~minors) return false;
+  return ((key >> 4) & 15) + ((key >> 8) & 15) <= 1 &&
+         ((key >> 24) & 15) + ((key >> 28) & 15) <= 1;
+}
+
+// scale factors apply to the score of the side ahead, in 64ths
+constexpr int full_scale = 64;
+constexpr int drawish_scale = 8;
+
+struct entry {
+  uint64_t key;
+  int score;  // imbalance terms, packed midgame and endgame, white's view
+  uint8_t phase;  // game phase of the material, see evaluation::taper
+  bool insufficient;  // is_insufficient
+  bool drawish;       // neither side can be expected to win
+  uint8_t scale[2];   // for white and black being ahead
+};
+
+// game phase of the material, see evaluation::taper
+int phase(uint64_t key);
+
+// everything follows from the counts, the board is not needed
+entry evaluate(uint64_t key);
+
+// fixed size, always replace, one table per search thread like
+// pawns::table
+class table {
+  std::vector<entry> entries;
+  unsigned shift;  // keys are hashed to the top bits, see probe
+  uint64_t probes, hits;
+
+ public:
+  // entries, a power of 2
+  static constexpr size_t default_size = 1 << 12;
+
+  table(size_t = default_size);
+
+  // the cached entry for key, evaluated first on a miss
+  const entry &probe(uint64_t key);
+
+  void clear();
+
+  // lookups and cache hits since the last clear
+  uint64_t get_probes() const;
+  uint64_t get_hits() const;
+};
+
+inline uint64_t table::get_probes() const { return probes; }
+inline uint64_t table::get_hits() const { return hits; }
+
+}  // namespace abra::material
+
+#endif
@@ -1,232 +1,606 @@
+#include <array>
+#include <cmath>
 #include <iostream>
+#include <thread>
 
+#include "evaluation.h"
 #include "search.h"
 
 namespace abra {
 
-const int inf = int(1e5);
+// bounds every score, must fit in the 16 bit score of a transposition
+// table entry
+const int inf = mate_score;
 
-minimax_search::minimax_search(size_t cache_size) {
-  max_cache_size = cache_size;
+// deepest iteration, also bounds the recursion when there is no depth limit
+const int max_depth = 64;
+
+// half width of the first aspiration window, doubled on every fail
+const int aspiration_window = 25;
+
+// null move pruning searches the reply to a pass with this reduction,
+// deeper searches are reduced more
+const int null_move_reduction = 3;
+
+// nodes this close to the horizon are pruned if the static evaluation is
+// this far from the window per remaining ply
+const int futility_depth = 3;
+const int futility_margin = 100;
+
+// late moves are reduced once this many moves have been searched, quiet
+// moves which often cut off are reduced by one ply less
+const int reduction_moves = 3;
+const int reduction_history = 1 << 12;
+
+// a capture is skipped in quiescence if even winning the piece plus this
+// margin cannot bring the score up to alpha (or down to beta)
+const int delta_margin = 200;
+
+// helper threads skip some iterations so that they spread over the next
+// few depths instead of all searching the same one
+const int skip_size[] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+                         3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+const int skip_phase[] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3,
+                          4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+search_worker::search_worker(int _id, const game &g)
+    : id{_id},
+      pos{g},
+      root_move{},
+      nodes{0},
+      qnodes{0},
+      completed_depth{0},
+      best{0, move{}},
+      pv_length{} {}
+
+void search_worker::update_pv(int ply, move m) {
+  if (ply >= max_ply) return;
+  pv[ply][0] = m;
+  auto child = (ply + 1 < max_ply ? pv_length[ply + 1] : 0);
+  std::copy(pv[ply + 1], pv[ply + 1] + child, pv[ply] + 1);
+  pv_length[ply] = child + 1;
 }
 
-// TODO: return prematurely if time crosses max_time
-std::pair<int, move> minimax_search::choose_move(const game &g, int max_time) {
-  // return minimax(g, 6, -inf, inf);
-  auto guess = 0;
-  auto max_depth = 6;
-  for (int d = 1; d <= max_depth; d++) {
-    guess = mtdf(g, d, guess);
-  }
-  auto st = std::make_pair(g, max_depth - 1);
-  assert(cache.find(st) != cache.end());  // move should be present in cache
-  return {guess, cache[st].m};
-}
-
-// clang-format off
-// Piece Square Table: taken from https://www.chessprogramming.org/Simplified_Evaluation_Function
-// modify to change evaluation function & bot behaviour
-const int pst[][64] = {
-  // pawn
-  {
-     0,  0,  0,  0,  0,  0,  0,  0,
-    50, 50, 50, 50, 50, 50, 50, 50,
-    10, 10, 20, 30, 30, 20, 10, 10,
-     5,  5, 10, 25, 25, 10,  5,  5,
-     0,  0,  0, 20, 20,  0,  0,  0,
-     5, -5,-10,  0,  0,-10, -5,  5,
-     5, 10, 10,-20,-20, 10, 10,  5,
-     0,  0,  0,  0,  0,  0,  0,  0
-  },
-  // knight
-  {
-    -50,-40,-30,-30,-30,-30,-40,-50,
-    -40,-20,  0,  0,  0,  0,-20,-40,
-    -30,  0, 10, 15, 15, 10,  0,-30,
-    -30,  5, 15, 20, 20, 15,  5,-30,
-    -30,  0, 15, 20, 20, 15,  0,-30,
-    -30,  5, 10, 15, 15, 10,  5,-30,
-    -40,-20,  0,  5,  5,  0,-20,-40,
-    -50,-40,-30,-30,-30,-30,-40,-50,
-  },
-  // bishop
-  {
-    -20,-10,-10,-10,-10,-10,-10,-20,
-    -10,  0,  0,  0,  0,  0,  0,-10,
-    -10,  0,  5, 10, 10,  5,  0,-10,
-    -10,  5,  5, 10, 10,  5,  5,-10,
-    -10,  0, 10, 10, 10, 10,  0,-10,
-    -10, 10, 10, 10, 10, 10, 10,-10,
-    -10,  5,  0,  0,  0,  0,  5,-10,
-    -20,-10,-10,-10,-10,-10,-10,-20,
-  },
-  // rook
-  {
-    0,  0,  0,  0,  0,  0,  0,  0,
-    5, 10, 10, 10, 10, 10, 10,  5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    -5,  0,  0,  0,  0,  0,  0, -5,
-    0,  0,  0,  5,  5,  0,  0,  0
-  },
-  // queen
-  {
-    -20,-10,-10, -5, -5,-10,-10,-20,
-    -10,  0,  0,  0,  0,  0,  0,-10,
-    -10,  0,  5,  5,  5,  5,  0,-10,
-     -5,  0,  5,  5,  5,  5,  0, -5,
-      0,  0,  5,  5,  5,  5,  0, -5,
-    -10,  5,  5,  5,  5,  5,  0,-10,
-    -10,  0,  5,  0,  0,  0,  0,-10,
-    -20,-10,-10, -5, -5,-10,-10,-20
-  },
-  // king - midgame
-  {
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -30,-40,-40,-50,-50,-40,-40,-30,
-    -20,-30,-30,-40,-40,-30,-30,-20,
-    -10,-20,-20,-20,-20,-20,-20,-10,
-     20, 20,  0,  0,  0,  0, 20, 20,
-     20, 30, 10,  0,  0, 10, 30, 20
-
-  },
-  // king - endgame
-  {
-    -50,-40,-30,-20,-20,-30,-40,-50,
-    -30,-20,-10,  0,  0,-10,-20,-30,
-    -30,-10, 20, 30, 30, 20,-10,-30,
-    -30,-10, 30, 40, 40, 30,-10,-30,
-    -30,-10, 30, 40, 40, 30,-10,-30,
-    -30,-10, 20, 30, 30, 20,-10,-30,
-    -30,-30,  0,  0,  0,  0,-30,-30,
-    -50,-30,-30,-30,-30,-30,-30,-50
-  }
-};
-
-// piece values for P N B R Q K
-const int pv[] = { 100, 320, 330, 500, 900, 20000 };
-// clang-format on
-
-// return a score indicating how good this position is
-int score(const game &g) {
-  if (g.is_terminal()) {
-    auto winner = g.get_result();
-    if (winner == color::none) return 0;
-    return (winner == color::white ? inf : -inf);
+minimax_search::minimax_search(size_t hash_mb)
+    : tt{hash_mb},
+      thread_count{1},
+      driver{search_driver::pvs},
+      stopped{false} {}
+
+void minimax_search::set_info_callback(
+    std::function<void(const search_info &)> callback) {
+  on_iteration = std::move(callback);
+}
+
+void minimax_search::set_hash_size(size_t mb) { tt.resize(mb); }
+
+void minimax_search::set_threads(int n) { thread_count = std::max(n, 1); }
+
+void minimax_search::set_driver(search_driver d) { driver = d; }
+
+void minimax_search::set_network(std::shared_ptr<const nnue::network> n) {
+  net = std::move(n);
+}
+
+void minimax_search::set_options(const search_options &o) { options = o; }
+
+void minimax_search::clear() { tt.clear(); }
+
+uint64_t minimax_search::get_nodes() const {
+  auto total = uint64_t{0};
+  for (auto &w : workers) total += w->nodes.load(std::memory_order_relaxed);
+  return total;
+}
+
+uint64_t minimax_search::get_qnodes() const {
+  auto total = uint64_t{0};
+  for (auto &w : workers) total += w->qnodes.load(std::memory_order_relaxed);
+  return total;
+}
+
+uint64_t minimax_search::get_pawn_probes() const {
+  auto total = uint64_t{0};
+  for (auto &w : workers) total += w->pawn_table.get_probes();
+  return total;
+}
+
+uint64_t minimax_search::get_pawn_hits() const {
+  auto total = uint64_t{0};
+  for (auto &w : workers) total += w->pawn_table.get_hits();
+  return total;
+}
+
+uint64_t minimax_search::get_material_probes() const {
+  auto total = uint64_t{0};
+  for (auto &w : workers) total += w->material_table.get_probes();
+  return total;
+}
+
+uint64_t minimax_search::get_material_hits() const {
+  auto total = uint64_t{0};
+  for (auto &w : workers) total += w->material_table.get_hits();
+  return total;
+}
+
+int minimax_search::get_depth() const {
+  auto depth = 0;
+  for (auto &w : workers) depth = std::max(depth, w->completed_depth);
+  return depth;
+}
+
+// score for white when the side to move is mated at ply
+int mated_score(const game &g, int ply) {
+  return (g.get_color_to_move() == color::white ? -(inf - ply) : inf - ply);
+}
+
+// score for white when the side to move has no legal move
+int no_moves_score(const game &g, bool in_check, int ply) {
+  if (!in_check) return 0;  // stalemate
+  return mated_score(g, ply);
+}
+
+std::pair<int, move> minimax_search::choose_move(const game &g,
+                                                 const search_limits &limits) {
+  tm.init(limits);
+  tt.new_search();
+  stopped = false;
+  workers.clear();
+  // the game is over, there is nothing to search
+  auto moves = move_list{};
+  g.get_moves(moves);
+  if (moves.empty())
+    return {no_moves_score(g, g.in_check(g.get_color_to_move()), 0), move{}};
+  for (int i = 0; i < thread_count; i++)
+    workers.push_back(std::make_unique<search_worker>(i, g));
+  for (auto &w : workers) {
+    w->best = {0, moves[0]};
+    w->pos.set_network(net.get());
   }
-  auto board = g.get_board();
-  auto sc = 0;
-  for (int i = 0; i < 64; i++) {
-    auto p = board.get_piece(i);
-    if (p.ptype == piece_type::empty) continue;
-    auto j = static_cast<int>(p.ptype) - 1;  // subtract to make zero indexed
-    if (p.pcolor == color::white) {
-      sc += pst[j][i] + pv[j];
-    } else {
-      sc -= pst[j][63 - i] + pv[j];  // mirrored
+
+  auto depth_limit = (limits.depth > 0 ? std::min(limits.depth, max_depth)
+                                       : max_depth);
+  auto helpers = std::vector<std::thread>{};
+  for (int i = 1; i < thread_count; i++)
+    helpers.emplace_back([this, i, depth_limit]() {
+      iterate(*workers[i], depth_limit);
+    });
+  iterate(*workers[0], depth_limit);
+  stopped = true;
+  for (auto &t : helpers) t.join();
+
+  // the deepest completed iteration wins, ties go to the main thread
+  auto *best = workers[0].get();
+  for (auto &w : workers)
+    if (w->completed_depth > best->completed_depth) best = w.get();
+  return best->best;
+}
+
+void minimax_search::iterate(search_worker &w, int depth_limit) {
+  for (int d = 1; d <= depth_limit; d++) {
+    if (w.id > 0) {
+      auto i = (w.id - 1) % 20;
+      if ((d + skip_phase[i]) / skip_size[i] % 2) continue;
+    }
+    auto guess = (driver == search_driver::pvs ? aspiration(w, d, w.best.first)
+                                               : mtdf(w, d, w.best.first));
+    // an aborted iteration is incomplete, keep the previous result
+    if (stopped) break;
+    w.best = {guess, w.root_move};
+    w.completed_depth = d;
+    if (w.id > 0) continue;
+    if (on_iteration) {
+      // pvs collects its line while searching, mtdf leaves it in the table
+      auto pv = (driver == search_driver::pvs && w.pv_length[0] > 0
+                     ? std::vector<move>(w.pv[0], w.pv[0] + w.pv_length[0])
+                     : get_pv(w.pos, w.root_move, d));
+      on_iteration(search_info{d, guess, get_nodes(), tm.elapsed(),
+                               tt.hashfull(), pv});
     }
+    if (!tm.can_deepen(get_nodes())) break;
+  }
+}
+
+std::vector<move> minimax_search::get_pv(game &g, move root, int depth) {
+  auto pv = std::vector<move>{root};
+  g.make_move(root);
+  auto entry = tt_entry{};
+  while (static_cast<int>(pv.size()) < depth && tt.probe(g.get_hash(), entry)) {
+    // the entry may belong to another position with the same key bits
+    auto moves = move_list{};
+    g.get_moves(moves);
+    auto m = entry.get_move();
+    if (std::find(moves.begin(), moves.end(), m) == moves.end()) break;
+    pv.push_back(m);
+    g.make_move(m);
   }
-  return sc;
+  for (auto i = pv.size(); i > 0; i--) g.unmake_move();
+  return pv;
+}
+
+// static score from white's perspective, never generates moves (the search
+// finds mates and stalemates by running out of legal moves)
+int evaluate(search_worker &w) {
+  // both the piece-square score and the network accumulator are kept up to
+  // date by make_move, the pawn and material terms are mostly found in the
+  // tables
+  return w.pos.evaluate(w.pawn_table, w.material_table);
+}
+
+// the table holds mate scores as distances from the stored node rather than
+// from the root, so that they stay right when the position recurs at another
+// ply
+int to_tt(int score, int ply) {
+  if (score >= mate_bound) return score + ply;
+  if (score <= -mate_bound) return score - ply;
+  return score;
+}
+
+int from_tt(int score, int ply) {
+  if (score >= mate_bound) return score - ply;
+  if (score <= -mate_bound) return score + ply;
+  return score;
 }
 
 // Implement MTD(f), referred to from https://www.chessprogramming.org/MTD(f)
 
-int minimax_search::mtdf(const game &g, int depth, int f) {
+int minimax_search::mtdf(search_worker &w, int depth, int f) {
   auto guess = f;
   auto upper = inf;
   auto lower = -inf;
   auto beta = 0;
-  while (lower < upper) {
+  while (lower < upper && !stopped) {
     if (guess == lower) {
       beta = guess + 1;
     } else {
       beta = guess;
     }
-    guess = minimax(g, depth, beta - 1, beta);
+    guess = minimax(w, depth, 0, beta - 1, beta);
     if (guess < beta) {
       upper = guess;
     } else {
       lower = guess;
     }
   }
-  minimax(g, depth, beta - 1, beta); // to ensure presence in cache
   return guess;
 }
 
-int minimax_search::minimax(const game &g, int depth, int alpha, int beta) {
+int minimax_search::minimax(search_worker &w, int depth, int ply, int alpha,
+                            int beta) {
   using std::max;
   using std::min;
 
-  if (depth <= 0 || g.is_terminal()) return score(g);
+  visit(w);
+  if (stopped.load(std::memory_order_relaxed)) return 0;
+  auto &g = w.pos;
+  // a line that repeats is a draw whatever the earlier occurrence led to,
+  // a root drawn by rule is still searched for a move
+  if (ply > 0 && g.is_draw(1)) return 0;
 
-  auto moves = g.get_moves();
-  if (moves.empty()) return score(g);
+  if (depth <= 0) return quiesce(w, ply, alpha, beta);
 
-  auto st = std::make_pair(g, depth - 1);
-
-  if (cache.find(st) != cache.end()) {
-    auto &n = cache[st];
-    if (n.lb >= beta)
-      return n.lb;
-    if (n.ub <= alpha)
-      return n.ub;
-    alpha = max(alpha, n.lb);
-    beta = min(beta, n.ub);
-  } else {
-    if (cache.size() >= max_cache_size) cache.clear();
-    cache[st] = node_info{move{}, -inf, inf};
+  // the root is always searched, so that root_move is set by this pass
+  auto key = g.get_hash();
+  auto entry = tt_entry{};
+  auto tt_move = move{};
+  if (tt.probe(key, entry)) {
+    tt_move = entry.get_move();
+    auto b = entry.get_bound();
+    auto s = from_tt(entry.score, ply);
+    if (ply > 0 && entry.depth >= depth) {
+      if (b == bound::exact) return s;
+      if (b == bound::lower && s >= beta) return s;
+      if (b == bound::upper && s <= alpha) return s;
+    }
   }
 
-  auto &node = cache[st];
-
   auto guess = 0;
 
-  auto best_move = moves[0];
+  auto best_move = move{};
+  auto legal = 0;
+  auto picker = move_picker{g, tt_move, w.history, ply};
+  // a quiet move that cuts off is remembered for ordering siblings
+  auto on_cutoff = [&](move m) {
+    if (!is_capture(g, m) && m.flag() != move_flag::promotion)
+      w.history.update(g.get_color_to_move(), m, ply, depth);
+  };
 
-  if (depth == 0) {
-    guess = score(g);
-  } else if (g.get_color_to_move() == color::white) {  // Maximize
+  if (g.get_color_to_move() == color::white) {  // Maximize
     guess = -inf;
     auto alpha_new = alpha;
-    for (auto m : moves) {
-      game new_game{g};
-      new_game.make_move(m);
-      auto x = minimax(new_game, depth - 1, alpha_new, beta);
+    for (auto m = move{}; picker.next(m);) {
+      if (!g.is_legal(m)) continue;
+      legal++;
+      g.make_move(m);
+      auto x = minimax(w, depth - 1, ply + 1, alpha_new, beta);
+      g.unmake_move();
+      if (stopped.load(std::memory_order_relaxed)) return 0;
       if (x > guess) {
         guess = x;
         best_move = m;
       }
-      if (guess >= beta) break;
+      if (guess >= beta) {
+        on_cutoff(m);
+        break;
+      }
       alpha_new = max(alpha_new, guess);
     }
+    if (ply == 0 && guess > alpha) w.root_move = best_move;
   } else {  // Minimize
     guess = inf;
     auto beta_new = beta;
-    for (auto m : moves) {
-      game new_game{g};
-      new_game.make_move(m);
-      auto x = minimax(new_game, depth - 1, alpha, beta_new);
+    for (auto m = move{}; picker.next(m);) {
+      if (!g.is_legal(m)) continue;
+      legal++;
+      g.make_move(m);
+      auto x = minimax(w, depth - 1, ply + 1, alpha, beta_new);
+      g.unmake_move();
+      if (stopped.load(std::memory_order_relaxed)) return 0;
       if (x < guess) {
         guess = x;
         best_move = m;
       }
-      if (guess <= alpha) break;
+      if (guess <= alpha) {
+        on_cutoff(m);
+        break;
+      }
       beta_new = min(beta_new, guess);
     }
+    if (ply == 0 && guess < beta) w.root_move = best_move;
   }
-  node.m = best_move;
-  if (guess <= alpha) {
-    node.ub = guess;
-  } else if (guess < beta) {
-    node.lb = node.ub = guess;
-  } else {
-    node.lb = guess;
-  }
+  if (legal == 0)
+    return no_moves_score(g, g.in_check(g.get_color_to_move()), ply);
+
+  auto b = bound::exact;
+  if (guess <= alpha)
+    b = bound::upper;
+  else if (guess >= beta)
+    b = bound::lower;
+  tt.store(key, best_move, to_tt(guess, ply), depth, b);
   return guess;
 }
 
+// Quiescence search, see https://www.chessprogramming.org/Quiescence_Search
+// only captures are searched (all evasions when in check), the side to move
+// may also stand pat on the static score
+
+int minimax_search::quiesce(search_worker &w, int ply, int alpha, int beta) {
+  visit(w);
+  w.qnodes.store(w.qnodes.load(std::memory_order_relaxed) + 1,
+                 std::memory_order_relaxed);
+  if (stopped.load(std::memory_order_relaxed)) return 0;
+  auto &g = w.pos;
+
+  auto in_check = g.in_check(g.get_color_to_move());
+  auto moves = move_list{};
+  g.get_moves(moves, !in_check);
+  if (in_check && moves.empty())  // checkmate
+    return mated_score(g, ply);
+
+  auto stand_pat = evaluate(w);
+  // value of the piece a move wins, for delta pruning
+  auto gain = [&](move m) {
+    auto victim = (m.flag() == move_flag::en_passant
+                       ? piece_type::pawn
+                       : g.piece_at(m.to()).ptype);
+    auto promotion = m.promotion();
+    auto value = evaluation::pv_mg[static_cast<int>(victim) - 1];
+    if (promotion != piece_type::empty)
+      value += evaluation::pv_mg[static_cast<int>(promotion) - 1] -
+               evaluation::pv_mg[0];
+    return value;
+  };
+
+  auto orderer = move_orderer{g, moves, move{}, w.history, ply};
+  if (g.get_color_to_move() == color::white) {  // Maximize
+    auto guess = (in_check ? -inf : stand_pat);
+    if (guess >= beta) return guess;
+    alpha = std::max(alpha, guess);
+    for (auto m = move{}; orderer.next(m);) {
+      if (!in_check && stand_pat + gain(m) + delta_margin <= alpha) continue;
+      g.make_move(m);
+      auto x = quiesce(w, ply + 1, alpha, beta);
+      g.unmake_move();
+      if (stopped.load(std::memory_order_relaxed)) return 0;
+      guess = std::max(guess, x);
+      if (guess >= beta) break;
+      alpha = std::max(alpha, guess);
+    }
+    return guess;
+  } else {  // Minimize
+    auto guess = (in_check ? inf : stand_pat);
+    if (guess <= alpha) return guess;
+    beta = std::min(beta, guess);
+    for (auto m = move{}; orderer.next(m);) {
+      if (!in_check && stand_pat - gain(m) - delta_margin >= beta) continue;
+      g.make_move(m);
+      auto x = quiesce(w, ply + 1, alpha, beta);
+      g.unmake_move();
+      if (stopped.load(std::memory_order_relaxed)) return 0;
+      guess = std::min(guess, x);
+      if (guess <= alpha) break;
+      beta = std::min(beta, guess);
+    }
+    return guess;
+  }
+}
+
+// Principal variation search, see
+// https://www.chessprogramming.org/Principal_Variation_Search
+
+namespace {
+
+// bounds swap meaning when the score is seen from the other side
+bound flip(bound b) {
+  if (b == bound::lower) return bound::upper;
+  if (b == bound::upper) return bound::lower;
+  return b;
+}
+
+// plies by which a late move is reduced, grows with both the depth and the
+// number of moves searched before it
+int late_move_reduction(int depth, int index) {
+  static const auto table = []() {
+    auto t = std::array<std::array<int, 64>, 64>{};
+    for (int d = 1; d < 64; d++)
+      for (int i = 1; i < 64; i++)
+        t[d][i] = static_cast<int>(0.75 + std::log(d) * std::log(i) / 2.25);
+    return t;
+  }();
+  return table[std::min(depth, 63)][std::min(index, 63)];
+}
+
+}  // namespace
+
+int minimax_search::aspiration(search_worker &w, int depth, int previous) {
+  // previous is from white's perspective, like the returned score
+  auto sign = (w.pos.get_color_to_move() == color::white ? 1 : -1);
+  auto guess = sign * previous;
+  auto delta = aspiration_window;
+  auto alpha = -inf, beta = inf;
+  if (depth >= 4) {  // shallow scores are too unstable to bet on
+    alpha = std::max(guess - delta, -inf);
+    beta = std::min(guess + delta, inf);
+  }
+  while (true) {
+    auto x = pvs(w, depth, 0, alpha, beta);
+    if (stopped) return 0;
+    if (x <= alpha && alpha > -inf) {
+      alpha = std::max(x - delta, -inf);
+    } else if (x >= beta && beta < inf) {
+      beta = std::min(x + delta, inf);
+    } else {
+      return sign * x;
+    }
+    delta *= 2;
+  }
+}
+
+int minimax_search::pvs(search_worker &w, int depth, int ply, int alpha,
+                        int beta) {
+  visit(w);
+  if (stopped.load(std::memory_order_relaxed)) return 0;
+  auto &g = w.pos;
+  if (ply < max_ply) w.pv_length[ply] = 0;
+  if (ply > 0 && g.is_draw(1)) return 0;
+
+  // the evaluation and quiesce score for white
+  auto sign = (g.get_color_to_move() == color::white ? 1 : -1);
+  if (depth <= 0)
+    return (sign > 0 ? quiesce(w, ply, alpha, beta)
+                     : -quiesce(w, ply, -beta, -alpha));
+
+  // the table holds scores for white, pv nodes never cut off so that the
+  // line stays intact
+  auto pv_node = (beta - alpha > 1);
+  auto key = g.get_hash();
+  auto entry = tt_entry{};
+  auto tt_move = move{};
+  if (tt.probe(key, entry)) {
+    tt_move = entry.get_move();
+    auto b = (sign > 0 ? entry.get_bound() : flip(entry.get_bound()));
+    auto s = sign * from_tt(entry.score, ply);
+    if (ply > 0 && !pv_node && entry.depth >= depth) {
+      if (b == bound::exact) return s;
+      if (b == bound::lower && s >= beta) return s;
+      if (b == bound::upper && s <= alpha) return s;
+    }
+  }
+
+  // selective search, only where a wrong guess cannot lose the line
+  // (mate scores are never pruned)
+  auto us = g.get_color_to_move();
+  auto in_check = g.in_check(us);
+  auto static_eval = sign * evaluate(w);
+  auto selective = (!pv_node && !in_check && ply > 0);
+  if (selective && options.futility && depth <= futility_depth &&
+      std::abs(beta) < mate_bound && static_eval - futility_margin * depth >= beta)
+    return static_eval;
+  // if passing still fails high a real move will too, unless every move
+  // makes things worse, which is likely only without pieces (zugzwang)
+  // a pass is never answered by a pass, that would search the same position
+  // again with less depth (the network evaluation is not symmetric under a
+  // pass, so static_eval >= beta alone does not rule it out)
+  if (selective && options.null_move && depth > null_move_reduction &&
+      std::abs(beta) < mate_bound && static_eval >= beta &&
+      !g.is_after_null_move() && g.has_non_pawn_material(us)) {
+    auto r = null_move_reduction + depth / 6;
+    g.make_null_move();
+    auto x = -pvs(w, depth - 1 - r, ply + 1, -beta, -beta + 1);
+    g.unmake_move();
+    if (stopped.load(std::memory_order_relaxed)) return 0;
+    if (x >= beta) return (x >= mate_bound ? beta : x);
+  }
+  // quiet moves cannot bring the score up to alpha
+  auto futile = (selective && options.futility && depth <= futility_depth &&
+                 std::abs(alpha) < mate_bound &&
+                 static_eval + futility_margin * depth <= alpha);
+
+  auto original_alpha = alpha;
+  auto best = -inf;
+  auto best_move = move{};
+  auto picker = move_picker{g, tt_move, w.history, ply};
+  auto searched = 0;
+  for (auto m = move{}; picker.next(m);) {
+    if (!g.is_legal(m)) continue;
+    auto quiet = !is_capture(g, m) && m.flag() != move_flag::promotion;
+    g.make_move(m);
+    auto gives_check = g.in_check(g.get_color_to_move());
+    if (futile && quiet && !gives_check && searched > 0) {
+      g.unmake_move();
+      best = std::max(best, static_eval + futility_margin * depth);
+      continue;
+    }
+
+    auto x = 0;
+    if (searched == 0) {
+      x = -pvs(w, depth - 1, ply + 1, -beta, -alpha);
+    } else {
+      // late quiet moves are searched shallower first, if one beats alpha
+      // it is searched again at full depth
+      auto r = 0;
+      if (options.reductions && depth >= 3 && searched >= reduction_moves &&
+          quiet && !in_check && !gives_check) {
+        r = late_move_reduction(depth, searched);
+        if (w.history.get(us, m) >= reduction_history) r--;
+        if (pv_node) r--;
+        r = std::clamp(r, 0, depth - 2);
+      }
+      // prove the move is worse than the best one, search it fully if not
+      x = -pvs(w, depth - 1 - r, ply + 1, -alpha - 1, -alpha);
+      if (r > 0 && x > alpha)
+        x = -pvs(w, depth - 1, ply + 1, -alpha - 1, -alpha);
+      if (alpha < x && x < beta)
+        x = -pvs(w, depth - 1, ply + 1, -beta, -alpha);
+    }
+    g.unmake_move();
+    if (stopped.load(std::memory_order_relaxed)) return 0;
+    searched++;
+
+    if (x > best) {
+      best = x;
+      best_move = m;
+      if (x > alpha) {
+        alpha = x;
+        w.update_pv(ply, m);
+        if (ply == 0) w.root_move = m;
+      }
+    }
+    if (alpha >= beta) {
+      if (quiet) w.history.update(us, m, ply, depth);
+      break;
+    }
+  }
+  // futility pruning always searches a move first, so none were legal
+  if (searched == 0) return sign * no_moves_score(g, in_check, ply);
+
+  auto b = bound::exact;
+  if (best <= original_alpha)
+    b = bound::upper;
+  else if (best >= beta)
+    b = bound::lower;
+  tt.store(key, best_move, to_tt(sign * best, ply), depth,
+           sign > 0 ? b : flip(b));
+  return best;
+}
+
 }  // namespace abra
@@ -0,0 +1,172 @@
+#include "move_ordering.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace abra {
+
+namespace {
+
+// bands keep the groups apart, a group never outscores the one above it
+const int tt_move_score = 1 << 30;
+const int capture_score = 1 << 24;
+const int killer_score = 1 << 22;
+
+// history scores are halved before they could reach the killer band
+const int history_limit = 1 << 20;
+
+// piece types are declared from pawn to king, which is also their order
+// of value for mvv-lva
+int value(piece_type t) { return static_cast<int>(t); }
+
+int color_index(color c) { return (c == color::white ? 0 : 1); }
+
+// mvv-lva, a promotion counts the new piece as if it was captured
+int capture_order(const game &g, move m) {
+  auto victim = (m.flag() == move_flag::en_passant ? piece_type::pawn
+                                                   : g.piece_at(m.to()).ptype);
+  auto attacker = g.piece_at(m.from()).ptype;
+  return 16 * (value(victim) + value(m.promotion())) - value(attacker);
+}
+
+}  // namespace
+
+bool is_capture(const game &g, move m) {
+  return m.flag() == move_flag::en_passant || !g.piece_at(m.to()).is_empty();
+}
+
+move_history::move_history() { clear(); }
+
+void move_history::clear() {
+  for (auto &k : killers) k[0] = k[1] = move{};
+  for (auto &per_color : butterfly)
+    for (auto &per_from : per_color)
+      std::fill(std::begin(per_from), std::end(per_from), 0);
+}
+
+void move_history::update(color c, move m, int ply, int depth) {
+  if (ply < max_ply && killers[ply][0] != m) {
+    killers[ply][1] = killers[ply][0];
+    killers[ply][0] = m;
+  }
+  auto &h = butterfly[color_index(c)][m.from()][m.to()];
+  h += depth * depth;
+  if (h >= history_limit)
+    for (auto &per_from : butterfly[color_index(c)])
+      for (auto &x : per_from) x /= 2;
+}
+
+int move_history::get(color c, move m) const {
+  return butterfly[color_index(c)][m.from()][m.to()];
+}
+
+move_orderer::move_orderer(const game &g, move_list &_moves, move tt_move,
+                           const move_history &history, int ply)
+    : moves{_moves}, current{0} {
+  for (int i = 0; i < moves.size(); i++) {
+    auto m = moves[i];
+    auto &s = scores[i];
+    if (m == tt_move) {
+      s = tt_move_score;
+    } else if (is_capture(g, m) || m.flag() == move_flag::promotion) {
+      s = capture_score + capture_order(g, m);
+    } else if (ply < max_ply && m == history.killers[ply][0]) {
+      s = killer_score + 1;
+    } else if (ply < max_ply && m == history.killers[ply][1]) {
+      s = killer_score;
+    } else {
+      s = history.get(g.get_color_to_move(), m);
+    }
+  }
+}
+
+bool move_orderer::next(move &m) {
+  if (current >= moves.size()) return false;
+  // selection sort step, cutoffs usually come before the list is sorted
+  auto best = current;
+  for (int i = current + 1; i < moves.size(); i++)
+    if (scores[i] > scores[best]) best = i;
+  std::swap(moves[current], moves[best]);
+  std::swap(scores[current], scores[best]);
+  m = moves[current++];
+  return true;
+}
+
+move_picker::move_picker(const game &_g, move _tt_move,
+                         const move_history &_history, int ply)
+    : g{_g},
+      history{_history},
+      tt_move{_tt_move},
+      killers{move{}, move{}},
+      current_stage{stage::tt_move},
+      current{0},
+      killer_index{0} {
+  if (ply < max_ply) {
+    killers[0] = history.killers[ply][0];
+    killers[1] = history.killers[ply][1];
+  }
+}
+
+bool move_picker::select(move &m) {
+  if (current >= moves.size()) return false;
+  auto best = current;
+  for (int i = current + 1; i < moves.size(); i++)
+    if (scores[i] > scores[best]) best = i;
+  std::swap(moves[current], moves[best]);
+  std::swap(scores[current], scores[best]);
+  m = moves[current++];
+  return true;
+}
+
+bool move_picker::next(move &m) {
+  switch (current_stage) {
+    case stage::tt_move:
+      current_stage = stage::generate_captures;
+      if (g.is_pseudo_legal(tt_move)) {
+        m = tt_move;
+        return true;
+      }
+      [[fallthrough]];
+    case stage::generate_captures:
+      g.get_pseudo_moves(moves, true);
+      for (int i = 0; i < moves.size(); i++)
+        scores[i] = capture_order(g, moves[i]);
+      current_stage = stage::captures;
+      [[fallthrough]];
+    case stage::captures:
+      while (select(m))
+        if (m != tt_move) return true;
+      current_stage = stage::killers;
+      [[fallthrough]];
+    case stage::killers:
+      // a killer may have become a capture, which was handed out already
+      while (killer_index < 2) {
+        auto k = killers[killer_index++];
+        if (k != tt_move && !is_capture(g, k) &&
+            k.flag() != move_flag::promotion && g.is_pseudo_legal(k)) {
+          m = k;
+          return true;
+        }
+      }
+      current_stage = stage::generate_quiets;
+      [[fallthrough]];
+    case stage::generate_quiets:
+      moves.clear();
+      current = 0;
+      g.get_pseudo_moves(moves, false);
+      for (int i = 0; i < moves.size(); i++)
+        scores[i] = history.get(g.get_color_to_move(), moves[i]);
+      current_stage = stage::quiets;
+      [[fallthrough]];
+    case stage::quiets:
+      while (select(m))
+        if (m != tt_move && m != killers[0] && m != killers[1]) return true;
+      current_stage = stage::done;
+      [[fallthrough]];
+    case stage::done:
+      break;
+  }
+  return false;
+}
+
+}  // namespace abra
@@ -0,0 +1,87 @@
+#ifndef ABRA_MOVE_ORDERING_H
+#define ABRA_MOVE_ORDERING_H
+
+#include "game.h"
+#include "types.h"
+
+// try the likely best moves first so that alpha-beta cuts off early, see
+// https://www.chessprogramming.org/Move_Ordering
+namespace abra {
+
+// deepest ply that has killer moves
+constexpr int max_ply = 128;
+
+// learnt from beta cutoffs during a search, owned by one search thread
+struct move_history {
+  move killers[max_ply][2];  // quiet moves which recently cut off at a ply
+  int butterfly[2][64][64];  // quiet cutoff counts per color, from and to
+
+  move_history();
+
+  // forget everything
+  void clear();
+
+  // a quiet move caused a cutoff
+  void update(color, move, int ply, int depth);
+
+  // butterfly count of a quiet move
+  int get(color, move) const;
+};
+
+// hands out the moves of a list best first, scoring them once and then
+// selecting the highest remaining one on every call
+// order: table move, captures by mvv-lva, killers, quiets by history
+class move_orderer {
+  move_list &moves;
+  int scores[256];
+  int current;
+
+ public:
+  move_orderer(const game &, move_list &, move tt_move, const move_history &,
+               int ply);
+
+  // store the next move in m, returns false when all moves are done
+  bool next(move &m);
+};
+
+// hands out the moves of a node in stages, each generated only when the
+// one before runs out, since most nodes cut off after a move or two
+// stages: table move, captures and promotions by mvv-lva, killers, quiets
+// by history
+// moves are pseudo legal, test game::is_legal before making them
+class move_picker {
+  enum class stage {
+    tt_move,
+    generate_captures,
+    captures,
+    killers,
+    generate_quiets,
+    quiets,
+    done
+  };
+
+  const game &g;
+  const move_history &history;
+  move tt_move;
+  move killers[2];
+  stage current_stage;
+  move_list moves;
+  int scores[256];
+  int current, killer_index;
+
+  // store the best remaining move of the stage in m
+  bool select(move &m);
+
+ public:
+  move_picker(const game &, move tt_move, const move_history &, int ply);
+
+  // store the next move in m, returns false when all moves are done
+  bool next(move &m);
+};
+
+// true if the move takes a piece (including en passant)
+bool is_capture(const game &, move);
+
+}  // namespace abra
+
+#endif
@@ -0,0 +1,265 @@
+#include "nnue.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef ABRA_HAS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace abra::nnue {
+
+namespace {
+
+// the kernels, one set per instruction set
+struct kernels {
+  const char *name;
+  // acc += column, acc -= column (l1_size values)
+  void (*add)(int16_t *, const int16_t *);
+  void (*sub)(int16_t *, const int16_t *);
+  // clip l1_size sums to [0, activation_max]
+  void (*clip)(const int16_t *, uint8_t *);
+  // dot product of 2 * l1_size activations with a row of weights
+  int32_t (*dot)(const uint8_t *, const int8_t *);
+};
+
+void add_scalar(int16_t *acc, const int16_t *column) {
+  for (int i = 0; i < l1_size; i++) acc[i] += column[i];
+}
+
+void sub_scalar(int16_t *acc, const int16_t *column) {
+  for (int i = 0; i < l1_size; i++) acc[i] -= column[i];
+}
+
+void clip_scalar(const int16_t *sums, uint8_t *out) {
+  for (int i = 0; i < l1_size; i++)
+    out[i] = static_cast<uint8_t>(
+        std::clamp<int>(sums[i], 0, activation_max));
+}
+
+int32_t dot_scalar(const uint8_t *input, const int8_t *weights) {
+  auto sum = int32_t{0};
+  for (int i = 0; i < 2 * l1_size; i++) sum += input[i] * weights[i];
+  return sum;
+}
+
+#ifdef ABRA_HAS_X86_SIMD
+
+__attribute__((target("sse4.1"))) void add_sse41(int16_t *acc,
+                                                  const int16_t *column) {
+  for (int i = 0; i < l1_size; i += 8) {
+    auto a = _mm_load_si128(reinterpret_cast<const __m128i *>(acc + i));
+    auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(column + i));
+    _mm_store_si128(reinterpret_cast<__m128i *>(acc + i), _mm_add_epi16(a, c));
+  }
+}
+
+__attribute__((target("sse4.1"))) void sub_sse41(int16_t *acc,
+                                                  const int16_t *column) {
+  for (int i = 0; i < l1_size; i += 8) {
+    auto a = _mm_load_si128(reinterpret_cast<const __m128i *>(acc + i));
+    auto c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(column + i));
+    _mm_store_si128(reinterpret_cast<__m128i *>(acc + i), _mm_sub_epi16(a, c));
+  }
+}
+
+__attribute__((target("sse4.1"))) void clip_sse41(const int16_t *sums,
+                                                   uint8_t *out) {
+  auto zero = _mm_setzero_si128(), top = _mm_set1_epi16(activation_max);
+  for (int i = 0; i < l1_size; i += 16) {
+    auto a = _mm_load_si128(reinterpret_cast<const __m128i *>(sums + i));
+    auto b = _mm_load_si128(reinterpret_cast<const __m128i *>(sums + i + 8));
+    a = _mm_max_epi16(_mm_min_epi16(a, top), zero);
+    b = _mm_max_epi16(_mm_min_epi16(b, top), zero);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i),
+                     _mm_packus_epi16(a, b));
+  }
+}
+
+// maddubs cannot saturate: activations are at most 127, so a pair of
+// products stays within 2 * 127 * 128
+__attribute__((target("sse4.1"))) int32_t dot_sse41(const uint8_t *input,
+                                                     const int8_t *weights) {
+  auto ones = _mm_set1_epi16(1), sum = _mm_setzero_si128();
+  for (int i = 0; i < 2 * l1_size; i += 16) {
+    auto x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(input + i));
+    auto w = _mm_loadu_si128(reinterpret_cast<const __m128i *>(weights + i));
+    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(x, w), ones));
+  }
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4e));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xb1));
+  return _mm_cvtsi128_si32(sum);
+}
+
+__attribute__((target("avx2"))) void add_avx2(int16_t *acc,
+                                               const int16_t *column) {
+  for (int i = 0; i < l1_size; i += 16) {
+    auto a = _mm256_load_si256(reinterpret_cast<const __m256i *>(acc + i));
+    auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc + i),
+                       _mm256_add_epi16(a, c));
+  }
+}
+
+__attribute__((target("avx2"))) void sub_avx2(int16_t *acc,
+                                               const int16_t *column) {
+  for (int i = 0; i < l1_size; i += 16) {
+    auto a = _mm256_load_si256(reinterpret_cast<const __m256i *>(acc + i));
+    auto c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(acc + i),
+                       _mm256_sub_epi16(a, c));
+  }
+}
+
+// packing works within 128 bit lanes, the permute puts the halves back in
+// order
+__attribute__((target("avx2"))) void clip_avx2(const int16_t *sums,
+                                                uint8_t *out) {
+  auto zero = _mm256_setzero_si256(), top = _mm256_set1_epi16(activation_max);
+  for (int i = 0; i < l1_size; i += 32) {
+    auto a = _mm256_load_si256(reinterpret_cast<const __m256i *>(sums + i));
+    auto b =
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(sums + i + 16));
+    a = _mm256_max_epi16(_mm256_min_epi16(a, top), zero);
+    b = _mm256_max_epi16(_mm256_min_epi16(b, top), zero);
+    auto packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xd8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + i), packed);
+  }
+}
+
+__attribute__((target("avx2"))) int32_t dot_avx2(const uint8_t *input,
+                                                  const int8_t *weights) {
+  auto ones = _mm256_set1_epi16(1), sum = _mm256_setzero_si256();
+  for (int i = 0; i < 2 * l1_size; i += 32) {
+    auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(input + i));
+    auto w =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i));
+    sum = _mm256_add_epi32(sum,
+                           _mm256_madd_epi16(_mm256_maddubs_epi16(x, w), ones));
+  }
+  auto half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                            _mm256_extracti128_si256(sum, 1));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4e));
+  half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xb1));
+  return _mm_cvtsi128_si32(half);
+}
+
+#endif
+
+kernels select_kernels() {
+#ifdef ABRA_HAS_X86_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2"))
+    return kernels{"avx2", add_avx2, sub_avx2, clip_avx2, dot_avx2};
+  if (__builtin_cpu_supports("sse4.1"))
+    return kernels{"sse4.1", add_sse41, sub_sse41, clip_sse41, dot_sse41};
+#endif
+  return kernels{"scalar", add_scalar, sub_scalar, clip_scalar, dot_scalar};
+}
+
+const kernels &simd() {
+  static const auto k = select_kernels();
+  return k;
+}
+
+int perspective_index(color c) { return (c == color::white ? 0 : 1); }
+
+square king_square(const board64 &board, color c) {
+  return lsb(board.king & (c == color::white ? board.white : board.black));
+}
+
+const int16_t *column(const network &net, int feature) {
+  return net.feature_weights.data() + static_cast<size_t>(feature) * l1_size;
+}
+
+template <typename T>
+void read(std::ifstream &file, std::vector<T> &values, size_t count) {
+  values.resize(count);
+  file.read(reinterpret_cast<char *>(values.data()), count * sizeof(T));
+}
+
+}  // namespace
+
+std::shared_ptr<const network> load(const std::string &path) {
+  auto file = std::ifstream{path, std::ios::binary};
+  if (!file) throw new std::invalid_argument("cannot read network " + path);
+
+  char magic[8];
+  uint32_t header[3];
+  file.read(magic, sizeof(magic));
+  file.read(reinterpret_cast<char *>(header), sizeof(header));
+  if (!file || std::memcmp(magic, "ABRANNUE", 8) != 0 || header[0] != 1 ||
+      header[1] != l1_size || header[2] != l2_size)
+    throw new std::invalid_argument(path + " is not a supported network");
+
+  auto net = std::make_shared<network>();
+  read(file, net->feature_bias, l1_size);
+  read(file, net->feature_weights, static_cast<size_t>(feature_count) * l1_size);
+  read(file, net->hidden_bias, l2_size);
+  read(file, net->hidden_weights, l2_size * 2 * l1_size);
+  file.read(reinterpret_cast<char *>(&net->output_bias), sizeof(int32_t));
+  read(file, net->output_weights, l2_size);
+  if (!file) throw new std::invalid_argument(path + " is truncated");
+  return net;
+}
+
+int feature_index(color c, square king_sq, piece p, square s) {
+  if (c == color::black) {
+    king_sq = flip_square(king_sq);
+    s = flip_square(s);
+  }
+  auto type = static_cast<int>(p.ptype) - 1;  // pawn to queen
+  auto theirs = (p.pcolor == c ? 0 : 1);
+  return (king_sq * 10 + type * 2 + theirs) * 64 + s;
+}
+
+void refresh(const network &net, const board64 &board, color c,
+             accumulator &acc) {
+  auto values = acc.values[perspective_index(c)];
+  std::copy(net.feature_bias.begin(), net.feature_bias.end(), values);
+  auto king_sq = king_square(board, c);
+  for (auto pieces = bitboard{(board.white | board.black) & ~board.king};
+       pieces;) {
+    auto s = pop_lsb(pieces);
+    auto feature = feature_index(c, king_sq, board.get_piece(s), s);
+    simd().add(values, column(net, feature));
+  }
+}
+
+void add_piece(const network &net, const board64 &board, piece p, square s,
+               accumulator &acc) {
+  if (p.ptype == piece_type::king) return;
+  for (auto c : {color::white, color::black})
+    simd().add(acc.values[perspective_index(c)],
+               column(net, feature_index(c, king_square(board, c), p, s)));
+}
+
+void remove_piece(const network &net, const board64 &board, piece p, square s,
+                  accumulator &acc) {
+  if (p.ptype == piece_type::king) return;
+  for (auto c : {color::white, color::black})
+    simd().sub(acc.values[perspective_index(c)],
+               column(net, feature_index(c, king_square(board, c), p, s)));
+}
+
+int evaluate(const network &net, const accumulator &acc, color side) {
+  alignas(32) uint8_t input[2 * l1_size];
+  auto us = perspective_index(side);
+  simd().clip(acc.values[us], input);
+  simd().clip(acc.values[1 - us], input + l1_size);
+
+  auto output = net.output_bias;
+  for (int i = 0; i < l2_size; i++) {
+    auto sum = net.hidden_bias[i] +
+               simd().dot(input, net.hidden_weights.data() + i * 2 * l1_size);
+    auto hidden = std::clamp(sum >> weight_shift, 0, activation_max);
+    output += hidden * net.output_weights[i];
+  }
+  return std::clamp(output / output_divisor, -max_score, max_score);
+}
+
+const char *simd_name() { return simd().name; }
+
+}  // namespace abra::nnue
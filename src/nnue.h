@@ -0,0 +1,85 @@
+#ifndef ABRA_NNUE_H
+#define ABRA_NNUE_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "types.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ABRA_HAS_X86_SIMD 1
+#endif
+
+// efficiently updatable neural network evaluation, see
+// https://www.chessprogramming.org/NNUE
+//
+// features: for each side's point of view, every non-king piece is indexed
+// by that side's king square, the piece (type and whether it is ours) and its
+// square, with the board flipped for black (64 * 10 * 64 features)
+// layers: features -> 2 x l1_size (side to move first) -> l2_size -> 1
+namespace abra::nnue {
+
+constexpr int feature_count = 64 * 10 * 64;
+constexpr int l1_size = 256;
+constexpr int l2_size = 32;
+
+// activations are clipped to [0, activation_max], the hidden layer sum is
+// shifted down by weight_shift and the output is divided by output_divisor
+// to give centipawns
+constexpr int activation_max = 127;
+constexpr int weight_shift = 6;
+constexpr int output_divisor = 16;
+
+// evaluations are clamped well below mate scores
+constexpr int max_score = 20000;
+
+// quantised weights, loaded from a file with this layout (little endian):
+//   "ABRANNUE", uint32 version (1), uint32 l1_size, uint32 l2_size
+//   int16 feature_bias[l1_size]
+//   int16 feature_weights[feature_count][l1_size]
+//   int32 hidden_bias[l2_size]
+//   int8  hidden_weights[l2_size][2 * l1_size]
+//   int32 output_bias
+//   int8  output_weights[l2_size]
+struct network {
+  std::vector<int16_t> feature_bias;
+  std::vector<int16_t> feature_weights;
+  std::vector<int32_t> hidden_bias;
+  std::vector<int8_t> hidden_weights;
+  int32_t output_bias;
+  std::vector<int8_t> output_weights;
+};
+
+// first layer sums for both points of view (white, black), kept up to date
+// by game as pieces are put and removed
+struct accumulator {
+  alignas(32) int16_t values[2][l1_size];
+};
+
+// read a network, throws std::invalid_argument* if the file is not one
+std::shared_ptr<const network> load(const std::string &);
+
+// feature of a non-king piece on a square, seen by color whose king is on
+// king_sq
+int feature_index(color, square king_sq, piece, square);
+
+// recompute one point of view from scratch
+void refresh(const network &, const board64 &, color, accumulator &);
+
+// add or remove a piece for both points of view, kings are not features
+// (a king move refreshes its own side instead)
+void add_piece(const network &, const board64 &, piece, square, accumulator &);
+void remove_piece(const network &, const board64 &, piece, square,
+                  accumulator &);
+
+// score from the side to move's perspective in centipawns
+int evaluate(const network &, const accumulator &, color);
+
+// instruction set picked at startup for the kernels: avx2, sse4.1 or scalar
+const char *simd_name();
+
+}  // namespace abra::nnue
+
+#endif
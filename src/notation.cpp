@@ -1,5 +1,6 @@
 #include "notation.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cctype>
 #include <sstream>
@@ -30,7 +31,7 @@ std::string to_AN(color c) {
 
 std::string to_AN(piece p) {
   assert(!p.is_empty());
-  char symbol;
+  char symbol = '?';
   switch (p.ptype) {
     case piece_type::pawn:
       symbol = 'P';
@@ -58,8 +59,10 @@ std::string to_AN(piece p) {
 }
 
 std::string to_AN(move m) {
-  auto an = to_AN(m.from) + to_AN(m.to);
-  if (!m.promotion.is_empty()) an += to_AN(m.promotion);
+  auto an = to_AN(m.from()) + to_AN(m.to());
+  // promotions are always lowercase in long algebraic notation
+  if (m.flag() == move_flag::promotion)
+    an += to_AN(piece{color::black, m.promotion()});
   return an;
 }
 
@@ -75,25 +78,27 @@ std::string to_AN(castle_rights r) {
 
 std::string to_AN(const board64 &board) {
   auto an = std::string{""};
-  int empty = 0;
-  for (square i = 0; i < 64; i++) {
-    auto x = board.get_piece(i);
-    if (i % 8 == 0) {        // new row
-      if (i > 0) an += "/";  // add seperator if not first row
-      empty = 0;
-    }
-    if (x.is_empty()) {
-      empty++;
-    } else {
-      if (empty > 0) {
-        an += std::to_string(empty);
-        empty = 0;
-      }
-      an += to_AN(x);
+  // only occupied squares are visited, the gaps between them are counted
+  auto occupied = bitboard{board.white | board.black};
+  square next = 0;  // first square not yet written
+  auto end_square = [&]() {
+    if (++next % 8 == 0 && next < 64) an += "/";  // row separator
+  };
+  auto write_empty = [&](square upto) {
+    while (next < upto) {
+      auto gap = std::min(upto, next - get_col(next) + 8) - next;
+      an += std::to_string(gap);
+      next += gap - 1;
+      end_square();
     }
-    if (i % 8 == 7 && empty > 0)  // if last column, add spaces
-      an += std::to_string(empty);
+  };
+  while (occupied) {
+    auto i = pop_lsb(occupied);
+    write_empty(i);
+    an += to_AN(board.get_piece(i));
+    end_square();
   }
+  write_empty(64);
   return an;
 }
 
@@ -162,9 +167,14 @@ move to_move(const std::string &an) {
   if (an.size() != 4 && an.size() != 5)
     throw new std::invalid_argument("move '" + an +
                                     "' should have exactly 4 or 5 characters");
-  auto promote = (an.size() == 4 ? piece{} : to_piece(std::string{an[4]}));
   auto from_sq = an.substr(0, 2), to_sq = an.substr(2, 2);
-  return move{to_square(from_sq), to_square(to_sq), promote};
+  if (an.size() == 4) return move{to_square(from_sq), to_square(to_sq)};
+  auto promote = to_piece(std::string{an[4]}).ptype;
+  if (promote == piece_type::pawn || promote == piece_type::king)
+    throw new std::invalid_argument("move '" + an +
+                                    "' has invalid promotion piece");
+  return move{to_square(from_sq), to_square(to_sq), move_flag::promotion,
+              promote};
 }
 
 castle_rights to_castle_rights(const std::string &an) {
@@ -36,6 +36,8 @@ color to_color(const std::string &);
 piece to_piece(const std::string &);
 
 // convert long alg notation to move
+// castling and en passant are not flagged, match against legal moves by
+// comparing to_AN of both
 move to_move(const std::string &);
 
 // convert alg notation to castle_rights
@@ -0,0 +1,126 @@
+#include "pawns.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "evaluation.h"
+
+namespace abra::pawns {
+
+namespace {
+
+using evaluation::make_score;
+
+// clang-format off
+const int doubled = make_score(-10, -20);  // per pawn behind another
+const int isolated = make_score(-10, -15);  // no pawns on adjacent files
+// passed pawns by rank from the pawn's side, on top of the piece-square
+// tables which already reward advancing
+const int passed[] = {
+  make_score(0, 0), make_score(0, 5), make_score(5, 10), make_score(10, 20),
+  make_score(20, 35), make_score(35, 60), make_score(55, 90), make_score(0, 0)
+};
+// own pawns one and two ranks in front of a king on its first two ranks
+const int shield[] = { make_score(15, 0), make_score(8, 0) };
+// clang-format on
+
+struct masks {
+  bitboard files[8];
+  bitboard adjacent_files[8];
+  bitboard front_span[2][64];   // same file, ahead of the square
+  bitboard passed_span[2][64];  // same and adjacent files, ahead
+};
+
+constexpr masks make_masks() {
+  auto m = masks{};
+  for (int c = 0; c < 8; c++)
+    for (int r = 0; r < 8; r++) m.files[c] |= bitboard{1} << (r * 8 + c);
+  for (int c = 0; c < 8; c++)
+    m.adjacent_files[c] = (c > 0 ? m.files[c - 1] : 0) |
+                          (c < 7 ? m.files[c + 1] : 0);
+  for (int s = 0; s < 64; s++) {
+    auto row = s / 8, col = s % 8;
+    // white moves towards row 0, black towards row 7
+    auto ahead_white = (bitboard{1} << (row * 8)) - 1;
+    auto ahead_black = (row == 7 ? 0 : ~bitboard{0} << ((row + 1) * 8));
+    for (int i = 0; i < 2; i++) {
+      auto ahead = (i == 0 ? ahead_white : ahead_black);
+      m.front_span[i][s] = ahead & m.files[col];
+      m.passed_span[i][s] = ahead & (m.files[col] | m.adjacent_files[col]);
+    }
+  }
+  return m;
+}
+
+constexpr masks mask = make_masks();
+
+// rank counted from the side's first rank
+int relative_rank(int side, square s) {
+  return (side == 0 ? 7 - get_row(s) : get_row(s));
+}
+
+int shield_score(int side, square king, bitboard own_pawns) {
+  if (relative_rank(side, king) > 1) return 0;
+  auto score = 0;
+  auto dir = (side == 0 ? -8 : 8);
+  for (int i = 0; i < 2; i++) {
+    auto s = king + dir * (i + 1);
+    if (!is_valid_square(s)) break;
+    auto row = bitboard{0xff} << (get_row(s) * 8);
+    auto files = mask.files[get_col(s)] | mask.adjacent_files[get_col(s)];
+    score += shield[i] * popcount(bitboard{own_pawns & row & files});
+  }
+  return score;
+}
+
+}  // namespace
+
+entry evaluate(const board64 &board) {
+  auto e = entry{0, 0, {0, 0}};
+  for (int side = 0; side < 2; side++) {
+    auto own = board.pawn & (side == 0 ? board.white : board.black);
+    auto enemy = board.pawn & (side == 0 ? board.black : board.white);
+    auto score = 0;
+    for (auto pawns = own; pawns;) {
+      auto s = pop_lsb(pawns);
+      if (mask.front_span[side][s] & own) score += doubled;
+      if (!(mask.adjacent_files[get_col(s)] & own)) score += isolated;
+      // only the front one of doubled pawns can be passed
+      if (!(mask.passed_span[side][s] & enemy) &&
+          !(mask.front_span[side][s] & own)) {
+        set_bit(e.passed[side], s);
+        score += passed[relative_rank(side, s)];
+      }
+    }
+    auto king = lsb(board.king & (side == 0 ? board.white : board.black));
+    score += shield_score(side, king, own);
+    e.score += (side == 0 ? score : -score);
+  }
+  return e;
+}
+
+table::table(size_t size) : entries(size), probes{0}, hits{0} {
+  assert(size > 0 && (size & (size - 1)) == 0);
+  clear();
+}
+
+const entry &table::probe(const board64 &board, uint64_t key) {
+  auto &e = entries[key & (entries.size() - 1)];
+  probes++;
+  if (e.key == key) {
+    hits++;
+    return e;
+  }
+  e = evaluate(board);
+  e.key = key;
+  return e;
+}
+
+// an empty entry has the terms of a position without pawns, so it is
+// correct for key 0 too
+void table::clear() {
+  std::fill(entries.begin(), entries.end(), entry{0, 0, {0, 0}});
+  probes = hits = 0;
+}
+
+}  // namespace abra::pawns
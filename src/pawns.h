@@ -0,0 +1,51 @@
+#ifndef ABRA_PAWNS_H
+#define ABRA_PAWNS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+// pawn structure evaluation, cached by the pawn hash key of game, see
+// https://www.chessprogramming.org/Pawn_Hash_Table
+namespace abra::pawns {
+
+// the terms only depend on the pawns and the kings (for the shield), which
+// rarely change between sibling nodes
+struct entry {
+  uint64_t key;        // pawn hash key (pawns and kings)
+  int score;           // packed midgame and endgame, white's perspective
+  bitboard passed[2];  // passed pawns of white and black
+};
+
+// doubled, isolated and passed pawns and the pawn shield of both kings
+entry evaluate(const board64 &);
+
+// fixed size, always replace, one table per search thread so no locking
+class table {
+  std::vector<entry> entries;
+  uint64_t probes, hits;
+
+ public:
+  // entries, a power of 2
+  static constexpr size_t default_size = 1 << 14;
+
+  table(size_t = default_size);
+
+  // the cached entry for key, evaluated first on a miss
+  const entry &probe(const board64 &, uint64_t key);
+
+  void clear();
+
+  // lookups and cache hits since the last clear, for sizing the table
+  uint64_t get_probes() const;
+  uint64_t get_hits() const;
+};
+
+inline uint64_t table::get_probes() const { return probes; }
+inline uint64_t table::get_hits() const { return hits; }
+
+}  // namespace abra::pawns
+
+#endif
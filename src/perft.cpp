@@ -0,0 +1,114 @@
+#include "perft.h"
+
+namespace abra {
+
+// clang-format off
+const std::vector<perft_position> perft_suite = {
+  {"startpos",
+   "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+   {20, 400, 8902, 197281, 4865609, 119060324}},
+  {"kiwipete",
+   "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+   {48, 2039, 97862, 4085603, 193690690}},
+  {"position 3",
+   "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+   {14, 191, 2812, 43238, 674624, 11030083}},
+  {"position 4",
+   "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+   {6, 264, 9467, 422333, 15833292}},
+  {"position 5",
+   "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+   {44, 1486, 62379, 2103487, 89941194}},
+  {"position 6",
+   "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+   {46, 2079, 89890, 3894594, 164075551}},
+};
+
+const std::vector<perft_case> perft_edge_cases = {
+  {"illegal ep move #1", "3k4/3p4/8/K1P4r/8/8/8/8 b - - 0 1", 6, 1134888},
+  {"illegal ep move #2", "8/8/4k3/8/2p5/8/B2P2K1/8 w - - 0 1", 6, 1015133},
+  {"ep capture checks opponent", "8/8/1k6/2b5/2pP4/8/5K2/8 b - d3 0 1", 6, 1440467},
+  {"short castling gives check", "5k2/8/8/8/8/8/8/4K2R w K - 0 1", 6, 661072},
+  {"long castling gives check", "3k4/8/8/8/8/8/8/R3K3 w Q - 0 1", 6, 803711},
+  {"castle rights", "r3k2r/1b4bq/8/8/8/8/7B/R3K2R w KQkq - 0 1", 4, 1274206},
+  {"castling prevented", "r3k2r/8/3Q4/8/8/5q2/8/R3K2R b KQkq - 0 1", 4, 1720476},
+  {"promote out of check", "2K2r2/4P3/8/8/8/8/8/3k4 w - - 0 1", 6, 3821001},
+  {"discovered check", "8/8/1P2K3/8/2n5/1q6/8/5k2 b - - 0 1", 5, 1004658},
+  {"promote to give check", "4k3/1P6/8/8/8/8/K7/8 w - - 0 1", 6, 217342},
+  {"under promote to give check", "8/P1k5/K7/8/8/8/8/8 w - - 0 1", 6, 92683},
+  {"self stalemate", "K1k5/8/P7/8/8/8/8/8 w - - 0 1", 6, 2217},
+  {"stalemate & checkmate #1", "8/k1P5/8/1K6/8/8/8/8 w - - 0 1", 7, 567584},
+  {"stalemate & checkmate #2", "8/8/2k5/5q2/5n2/8/5K2/8 b - - 0 1", 4, 23527},
+};
+// clang-format on
+
+perft::perft(size_t hash_mb, bool bulk_count) : mask{0}, bulk{bulk_count} {
+  // round entry count down to a power of two
+  auto size = hash_mb * 1024 * 1024 / sizeof(entry);
+  if (size == 0) return;
+  auto n = size_t{1};
+  while (2 * n <= size) n *= 2;
+  table.resize(n);
+  mask = n - 1;
+  clear();
+}
+
+void perft::clear() {
+  for (auto &e : table) e = entry{0, 0, -1};
+}
+
+bool perft::probe(uint64_t key, int depth, uint64_t &nodes) const {
+  if (table.empty()) return false;
+  auto &e = table[key & mask];
+  if (e.key != key || e.depth != depth) return false;
+  nodes = e.nodes;
+  return true;
+}
+
+void perft::store(uint64_t key, int depth, uint64_t nodes) {
+  if (table.empty()) return;
+  table[key & mask] = entry{key, nodes, depth};
+}
+
+uint64_t perft::count(const game &g, int depth) {
+  auto pos = game{g};
+  return search(pos, depth);
+}
+
+// walks a single position, making and taking back each move
+uint64_t perft::search(game &g, int depth) {
+  if (depth <= 0) return 1;
+  auto moves = move_list{};
+  g.get_moves(moves);
+  if (depth == 1 && bulk) return moves.size();
+
+  // the last ply is too cheap to be worth a probe
+  auto key = g.get_hash();
+  auto nodes = uint64_t{0};
+  if (depth > 1 && probe(key, depth, nodes)) return nodes;
+
+  for (auto m : moves) {
+    g.make_move(m);
+    nodes += search(g, depth - 1);
+    g.unmake_move();
+  }
+
+  if (depth > 1) store(key, depth, nodes);
+  return nodes;
+}
+
+std::vector<std::pair<move, uint64_t>> perft::divide(const game &g,
+                                                     int depth) {
+  auto result = std::vector<std::pair<move, uint64_t>>{};
+  auto pos = game{g};
+  auto moves = move_list{};
+  pos.get_moves(moves);
+  for (auto m : moves) {
+    pos.make_move(m);
+    result.emplace_back(m, search(pos, depth - 1));
+    pos.unmake_move();
+  }
+  return result;
+}
+
+}  // namespace abra
@@ -0,0 +1,69 @@
+#ifndef ABRA_PERFT_H
+#define ABRA_PERFT_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "game.h"
+#include "types.h"
+
+namespace abra {
+
+// a position with known perft node counts, nodes[d - 1] is the count at depth d
+struct perft_position {
+  std::string name;
+  std::string fen;
+  std::vector<uint64_t> nodes;
+};
+
+// standard positions, taken from https://www.chessprogramming.org/Perft_Results
+extern const std::vector<perft_position> perft_suite;
+
+// a position with a single known node count
+struct perft_case {
+  std::string name;
+  std::string fen;
+  int depth;
+  uint64_t nodes;
+};
+
+// move generation edge cases (en passant discovered checks, castling through
+// attacks, promotions out of check, ...)
+extern const std::vector<perft_case> perft_edge_cases;
+
+// counts leaf nodes of the legal move tree, used to verify and measure
+// move generation
+class perft {
+  struct entry {
+    uint64_t key;
+    uint64_t nodes;
+    int depth;
+  };
+
+  std::vector<entry> table;
+  size_t mask;
+  bool bulk;
+
+  bool probe(uint64_t, int, uint64_t &) const;
+  void store(uint64_t, int, uint64_t);
+  uint64_t search(game &, int);
+
+ public:
+  // hash size in MB (0 disables the table), bulk counts the last ply
+  perft(size_t = 16, bool = true);
+
+  // return number of leaf nodes at depth
+  uint64_t count(const game &, int);
+
+  // return number of leaf nodes at depth below each root move
+  std::vector<std::pair<move, uint64_t>> divide(const game &, int);
+
+  // empty the hash table
+  void clear();
+};
+
+}  // namespace abra
+
+#endif
@@ -0,0 +1,129 @@
+#include <chrono>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "attacks.h"
+#include "game.h"
+#include "notation.h"
+#include "perft.h"
+#include "types.h"
+
+using namespace abra;
+using std::cout;
+
+struct perft_config {
+  std::string position;
+  int depth;
+  int divide_depth;
+  size_t hash_mb;
+  bool bulk;
+};
+
+// time a single perft run and print nodes/sec
+uint64_t run_perft(perft& p, const game& g, int depth) {
+  using namespace std::chrono;
+  auto begin = steady_clock::now();
+  auto nodes = p.count(g, depth);
+  auto end = steady_clock::now();
+  auto us = duration_cast<microseconds>(end - begin).count();
+  cout << "depth " << depth << ": " << nodes << " nodes " << us / 1000
+       << "ms " << (us > 0 ? nodes * 1000000 / us : 0) << " nps\n";
+  return nodes;
+}
+
+// run every position of the standard suite up to max depth, then the
+// edge cases at their given depth
+bool run_suite(perft_config& config) {
+  auto passed = true;
+  auto total = uint64_t{0};
+  auto begin = std::chrono::steady_clock::now();
+  for (auto& pos : perft_suite) {
+    cout << pos.name << ": " << pos.fen << "\n";
+    auto g = game{pos.fen};
+    // positions are independent, keep results comparable across them
+    auto p = perft{config.hash_mb, config.bulk};
+    for (int d = 1; d <= config.depth && d <= int(pos.nodes.size()); d++) {
+      auto nodes = run_perft(p, g, d);
+      total += nodes;
+      if (nodes != pos.nodes[d - 1]) {
+        cout << "FAILED: expected " << pos.nodes[d - 1] << "\n";
+        passed = false;
+      }
+    }
+  }
+  for (auto& pos : perft_edge_cases) {
+    cout << pos.name << ": " << pos.fen << "\n";
+    auto p = perft{config.hash_mb, config.bulk};
+    auto nodes = run_perft(p, game{pos.fen}, pos.depth);
+    total += nodes;
+    if (nodes != pos.nodes) {
+      cout << "FAILED: expected " << pos.nodes << "\n";
+      passed = false;
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(end - begin)
+                .count();
+  cout << (passed ? "all passed" : "some FAILED") << ": " << total
+       << " nodes " << ms << "ms " << (ms > 0 ? total * 1000 / ms : 0)
+       << " nps\n";
+  return passed;
+}
+
+void run_divide(perft_config& config) {
+  auto g = (config.position.empty() ? game{} : game{config.position});
+  auto p = perft{config.hash_mb, config.bulk};
+  auto total = uint64_t{0};
+  for (auto [m, nodes] : p.divide(g, config.divide_depth)) {
+    cout << notation::to_AN(m) << ": " << nodes << "\n";
+    total += nodes;
+  }
+  cout << "total: " << total << "\n";
+}
+
+int main(int argc, const char* argv[]) {
+  try {
+    auto config = perft_config{"", 0, 0, 16, true};
+    for (int i = 1; i < argc; i += 2) {
+      auto flg = std::string{argv[i]};
+      if (i + 1 >= argc)
+        throw new std::invalid_argument(flg + " does not have a value");
+      auto val = std::string{argv[i + 1]};
+      if (flg == "--fen") {
+        config.position = val;
+      } else if (flg == "--depth") {
+        config.depth = std::stoi(val);
+      } else if (flg == "--divide") {
+        config.divide_depth = std::stoi(val);
+      } else if (flg == "--hash") {
+        config.hash_mb = std::stoul(val);
+      } else if (flg == "--bulk") {
+        if (val == "on")
+          config.bulk = true;
+        else if (val == "off")
+          config.bulk = false;
+        else
+          throw new std::invalid_argument("invalid bulk " + val);
+      } else {
+        throw new std::invalid_argument("invalid arguement " + flg);
+      }
+    }
+    attacks::init();
+
+    if (config.divide_depth > 0) {
+      run_divide(config);
+    } else if (!config.position.empty()) {
+      auto g = game{config.position};
+      auto p = perft{config.hash_mb, config.bulk};
+      for (int d = 1; d <= config.depth; d++) run_perft(p, g, d);
+    } else {
+      if (config.depth <= 0) config.depth = 4;
+      return run_suite(config) ? 0 : 1;
+    }
+  } catch (std::invalid_argument* err) {
+    cout << "ERROR: " << err->what() << "\n";
+    return 1;
+  }
+  return 0;
+}
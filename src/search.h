@@ -2,13 +2,22 @@
 #define ABRA_SEARCH_H
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <memory>
 #include <random>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
 #include "game.h"
+#include "material.h"
+#include "move_ordering.h"
+#include "nnue.h"
+#include "pawns.h"
+#include "time_manager.h"
+#include "transposition_table.h"
 #include "types.h"
 
 using std::chrono::steady_clock;
@@ -20,41 +29,156 @@ class strategy {
  public:
   // return the chosen move along with an estimate of the score
   // by default, this just returns the first move and a score 0
-  virtual std::pair<int, move> choose_move(const game &g, int) {
-    auto moves = g.get_moves();
+  virtual std::pair<int, move> choose_move(const game &g,
+                                           const search_limits &) {
+    auto moves = move_list{};
+    g.get_moves(moves);
     return {-1, moves[0]};
   };
 };
 
-using state = std::pair<game, int>;
-struct node_info {
-  move m;
-  int lb, ub;
+// progress of a search, reported after every completed iteration
+struct search_info {
+  int depth;
+  int score;  // from white's perspective
+  uint64_t nodes;
+  int64_t time_ms;
+  int hashfull;  // permille of the transposition table used by this search
+  std::vector<move> pv;
 };
 
-class zobrist_hash {
-  uint64_t pieces[64][6][2];
-  uint64_t colors[2];
-  uint64_t castlings[4];
-  uint64_t ep_files[8];
-  uint64_t depths[8];
+// the side to move mated at ply p scores -(mate_score - p), so that shorter
+// mates score higher, any score beyond mate_bound is a mate
+constexpr int mate_score = 32000;
+constexpr int mate_bound = mate_score - max_ply;
 
- public:
-  zobrist_hash();
-  size_t operator()(const state &) const;
+// moves to mate for a mate score from the side to move's perspective,
+// negative when the side to move is mated
+inline int mate_in(int score) {
+  auto moves = (mate_score - std::abs(score) + 1) / 2;
+  return (score > 0 ? moves : -moves);
+}
+
+// algorithm driving each iteration at the root
+enum class search_driver {
+  mtdf,  // null window minimax passes converging on the score
+  pvs    // negamax principal variation search with aspiration windows
+};
+
+// selective search in pvs, each part can be switched off to measure it
+struct search_options {
+  bool null_move = true;   // null move pruning
+  bool reductions = true;  // late move reductions
+  bool futility = true;    // (reverse) futility pruning near the leaves
+};
+
+// state owned by a single search thread, threads only share the
+// transposition table and the stop flag
+struct search_worker {
+  int id;    // 0 is the main thread
+  game pos;  // searched in place
+  move root_move;
+  std::atomic<uint64_t> nodes;  // only written by the owning thread
+  std::atomic<uint64_t> qnodes;  // the part of nodes spent in quiesce
+  int completed_depth;          // depth of the last iteration that finished
+  std::pair<int, move> best;    // result of that iteration
+  move_history history;         // killers and history for move ordering
+  pawns::table pawn_table;      // pawn structure terms of this thread
+  material::table material_table;  // and material signature terms
+  // triangular pv table, pv[ply] holds the best line found from ply
+  move pv[max_ply][max_ply];
+  int pv_length[max_ply];
+
+  search_worker(int, const game &);
+
+  // the best line from ply is move m followed by the line from ply + 1
+  void update_pv(int ply, move m);
 };
 
+// lazy smp, all threads search the same root and share results through the
+// transposition table, see https://www.chessprogramming.org/Lazy_SMP
 class minimax_search : public strategy {
-  std::unordered_map<state, node_info, zobrist_hash> cache;
-  size_t max_cache_size;
+  transposition_table tt;
+  time_manager tm;
+  int thread_count;
+  search_driver driver;
+  search_options options;
+  std::shared_ptr<const nnue::network> net;  // nullptr for piece-square only
+  std::vector<std::unique_ptr<search_worker>> workers;
+  std::atomic<bool> stopped;  // set when the limits are hit mid-iteration
+  std::function<void(const search_info &)> on_iteration;
+
+  // iterative deepening on one thread
+  void iterate(search_worker &, int);
+
+  // count a node, the main thread also polls the limits
+  void visit(search_worker &);
+
+  // follow best moves stored in the table, starting with the root move
+  std::vector<move> get_pv(game &, move, int);
 
  public:
-  minimax_search(size_t = size_t(1e7));
-  std::pair<int, move> choose_move(const game &g, int) override;
-  int mtdf(const game &, int, int);
-  int minimax(const game &, int, int, int);
+  // transposition table size in MB
+  minimax_search(size_t = 16);
+  // iterative deepening within the limits, the result of the deepest
+  // completed iteration is returned
+  std::pair<int, move> choose_move(const game &g,
+                                   const search_limits &) override;
+  // the worker's position is searched in place and restored before returning
+  int mtdf(search_worker &, int, int);
+  int minimax(search_worker &, int, int, int, int);
+  // captures only search below the horizon, so leaves are quiet
+  int quiesce(search_worker &, int, int, int);
+  // root of a pvs iteration, the window around the previous score is
+  // widened until the score falls inside it
+  int aspiration(search_worker &, int, int);
+  // negamax with a null window for all but the first move, scores are
+  // from the side to move's perspective (unlike minimax and quiesce)
+  int pvs(search_worker &, int, int, int, int);
+  // nodes visited by all threads since the last choose_move
+  uint64_t get_nodes() const;
+  // of which in quiescence search
+  uint64_t get_qnodes() const;
+  // pawn table lookups and hits of all threads since the last choose_move,
+  // read after the search
+  uint64_t get_pawn_probes() const;
+  uint64_t get_pawn_hits() const;
+  // same for the material tables
+  uint64_t get_material_probes() const;
+  uint64_t get_material_hits() const;
+  // depth reached by the last choose_move
+  int get_depth() const;
+
+  // number of search threads (including the main thread)
+  void set_threads(int);
+
+  // algorithm used for each iteration
+  void set_driver(search_driver);
+
+  // pruning and reductions used by pvs
+  void set_options(const search_options &);
+
+  // evaluate with a network instead of the piece-square tables (nullptr)
+  void set_network(std::shared_ptr<const nnue::network>);
+
+  // called with the progress after every completed iteration
+  void set_info_callback(std::function<void(const search_info &)>);
+
+  // resize (and clear) the transposition table
+  void set_hash_size(size_t);
+
+  // forget everything learnt from previous searches
+  void clear();
 };
 
+inline void minimax_search::visit(search_worker &w) {
+  auto n = w.nodes.load(std::memory_order_relaxed) + 1;
+  w.nodes.store(n, std::memory_order_relaxed);
+  if (w.id == 0 && n % time_manager::poll_interval == 0 &&
+      tm.out_of_time(get_nodes()))
+    stopped.store(true, std::memory_order_relaxed);
+}
+
 }  // namespace abra
 
 #endif
@@ -0,0 +1,77 @@
+#include "time_manager.h"
+
+#include <algorithm>
+
+namespace abra {
+
+namespace {
+
+// time kept back for move overhead (output, the game loop, gui lag)
+const int64_t overhead_ms = 10;
+
+// moves assumed left in the game when the time control doesn't say
+const int64_t default_moves_to_go = 30;
+
+// budget when the clock has already run out, the game may still go on (the
+// gui may not enforce it) so a move is due quickly but not blindly
+const int64_t flagged_ms = 20;
+
+}  // namespace
+
+time_manager::time_manager()
+    : start{clock::now()},
+      soft_ms{-1},
+      hard_ms{-1},
+      iteration_start_ms{0},
+      last_iteration_ms{0},
+      max_nodes{0},
+      stop{nullptr} {}
+
+void time_manager::init(const search_limits &limits) {
+  start = clock::now();
+  soft_ms = hard_ms = -1;
+  iteration_start_ms = last_iteration_ms = 0;
+  max_nodes = limits.nodes;
+  stop = limits.stop;
+  if (limits.infinite) return;
+
+  if (limits.movetime > 0) {
+    soft_ms = hard_ms = std::max<int64_t>(limits.movetime - overhead_ms, 1);
+  } else if (limits.has_clock && limits.clock <= 0) {
+    soft_ms = hard_ms = flagged_ms;
+  } else if (limits.has_clock) {
+    // spread the clock over the remaining moves, may use a few times the
+    // share on a hard move but never more than a third of what is left
+    auto left = std::max<int64_t>(limits.clock - overhead_ms, 1);
+    auto moves_to_go =
+        (limits.moves_to_go > 0 ? limits.moves_to_go : default_moves_to_go);
+    soft_ms = left / moves_to_go + limits.increment * 3 / 4;
+    hard_ms = std::min(soft_ms * 4, left / 3);
+    soft_ms = std::max<int64_t>(std::min(soft_ms, hard_ms), 1);
+    hard_ms = std::max(hard_ms, soft_ms);
+  }
+}
+
+bool time_manager::out_of_time(uint64_t nodes) const {
+  if (stop && stop->load(std::memory_order_relaxed)) return true;
+  if (max_nodes > 0 && nodes >= max_nodes) return true;
+  return hard_ms >= 0 && elapsed() >= hard_ms;
+}
+
+bool time_manager::can_deepen(uint64_t nodes) {
+  if (stop && stop->load(std::memory_order_relaxed)) return false;
+  if (max_nodes > 0 && nodes >= max_nodes) return false;
+  if (soft_ms < 0) return true;
+  auto now = elapsed();
+  auto iteration_ms = now - iteration_start_ms;
+  // the next iteration grows by about the same factor as the last one did,
+  // don't start it if it would be cut off anyway
+  auto growth = std::max<int64_t>(
+      2, last_iteration_ms > 0 ? iteration_ms / last_iteration_ms : 0);
+  iteration_start_ms = now;
+  last_iteration_ms = iteration_ms;
+  if (now >= soft_ms) return false;
+  return now + growth * iteration_ms < hard_ms;
+}
+
+}  // namespace abra
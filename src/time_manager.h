@@ -0,0 +1,64 @@
+#ifndef ABRA_TIME_MANAGER_H
+#define ABRA_TIME_MANAGER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace abra {
+
+// what a search may spend, zero means no limit of that kind
+struct search_limits {
+  int movetime = 0;     // fixed time for this move (ms)
+  int clock = 0;        // time left on the clock of the side to move (ms)
+  bool has_clock = false;  // clock was given, even if it is 0 or negative
+  int increment = 0;    // increment per move (ms)
+  int moves_to_go = 0;  // moves until the next time control, 0 if unknown
+  int depth = 0;        // maximum iteration depth
+  uint64_t nodes = 0;   // node budget
+  bool infinite = false;  // search until stopped from outside
+  // set from another thread to abort the search, may be null
+  const std::atomic<bool> *stop = nullptr;
+};
+
+// decides when iterative deepening should stop, see
+// https://www.chessprogramming.org/Time_Management
+class time_manager {
+  using clock = std::chrono::steady_clock;
+
+  clock::time_point start;
+  int64_t soft_ms;  // no new iteration is started after this (-1 = none)
+  int64_t hard_ms;  // a running iteration is aborted after this (-1 = none)
+  int64_t iteration_start_ms;
+  int64_t last_iteration_ms;  // duration of the previous iteration
+  uint64_t max_nodes;
+  const std::atomic<bool> *stop;
+
+ public:
+  // the clock is only read every poll_interval nodes
+  static const uint64_t poll_interval = 1024;
+
+  time_manager();
+
+  // start the clock and derive the time budget from limits
+  void init(const search_limits &);
+
+  // milliseconds since init
+  int64_t elapsed() const;
+
+  // polled from inside the search, true if it has to be aborted now
+  bool out_of_time(uint64_t nodes) const;
+
+  // called after an iteration completes, true if the next one is
+  // expected to finish before the hard limit
+  bool can_deepen(uint64_t nodes);
+};
+
+inline int64_t time_manager::elapsed() const {
+  using namespace std::chrono;
+  return duration_cast<milliseconds>(clock::now() - start).count();
+}
+
+}  // namespace abra
+
+#endif
@@ -0,0 +1,116 @@
+#include "transposition_table.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace abra {
+
+namespace {
+
+tt_entry load(const std::atomic<uint64_t> &slot) {
+  auto data = slot.load(std::memory_order_relaxed);
+  auto e = tt_entry{};
+  std::memcpy(&e, &data, sizeof(e));
+  return e;
+}
+
+void save(std::atomic<uint64_t> &slot, const tt_entry &e) {
+  auto data = uint64_t{0};
+  std::memcpy(&data, &e, sizeof(e));
+  slot.store(data, std::memory_order_relaxed);
+}
+
+}  // namespace
+
+move tt_entry::get_move() const { return move::from_raw(move16); }
+
+transposition_table::transposition_table(size_t mb) : mask{0}, generation{0} {
+  resize(mb);
+}
+
+void transposition_table::resize(size_t mb) {
+  auto size = std::max<size_t>(mb * 1024 * 1024 / sizeof(bucket), 1);
+  auto n = size_t{1};
+  while (2 * n <= size) n *= 2;
+  buckets = std::vector<bucket>(n);
+  mask = n - 1;
+  clear();
+}
+
+void transposition_table::clear() {
+  for (auto &b : buckets)
+    for (auto &slot : b.entries) slot.store(0, std::memory_order_relaxed);
+  generation = 0;
+}
+
+void transposition_table::new_search() { generation = (generation + 1) & 63; }
+
+bool transposition_table::probe(uint64_t key, tt_entry &result) const {
+  auto key16 = static_cast<uint16_t>(key >> 48);
+  for (auto &slot : buckets[key & mask].entries) {
+    auto e = load(slot);
+    if (e.key16 == key16 && e.get_bound() != bound::none) {
+      result = e;
+      return true;
+    }
+  }
+  return false;
+}
+
+void transposition_table::store(uint64_t key, move m, int score, int depth,
+                                bound b) {
+  auto key16 = static_cast<uint16_t>(key >> 48);
+  auto &slots = buckets[key & mask].entries;
+
+  // reuse the slot of the same position, otherwise evict the entry with
+  // the lowest depth, counting each generation of age as 8 plies
+  // another thread may write the bucket meanwhile, that only costs an entry
+  auto victim = 0;
+  tt_entry entries[bucket_size];
+  auto worth = [&](const tt_entry &e) {
+    return e.depth - 8 * ((generation - e.get_generation()) & 63);
+  };
+  for (int i = 0; i < bucket_size; i++) {
+    entries[i] = load(slots[i]);
+    auto &e = entries[i];
+    if (e.key16 == key16 || e.get_bound() == bound::none) {
+      victim = i;
+      break;
+    }
+    if (worth(e) < worth(entries[victim])) victim = i;
+  }
+  auto &old = entries[victim];
+
+  // keep a deeper result for the same position from this search
+  if (old.key16 == key16 && old.get_bound() != bound::none &&
+      old.get_generation() == generation && b != bound::exact &&
+      depth < old.depth)
+    return;
+
+  // keep the old move if there is no new one
+  auto move16 = m.raw();
+  if (move16 == 0 && old.key16 == key16) move16 = old.move16;
+
+  auto e = tt_entry{};
+  e.key16 = key16;
+  e.move16 = move16;
+  e.score = static_cast<int16_t>(score);
+  e.depth = static_cast<int8_t>(depth);
+  e.gen_bound =
+      static_cast<uint8_t>((generation << 2) | static_cast<uint8_t>(b));
+  save(slots[victim], e);
+}
+
+int transposition_table::hashfull() const {
+  auto samples = std::min<size_t>(buckets.size(), 1000 / bucket_size);
+  auto used = 0;
+  for (size_t i = 0; i < samples; i++)
+    for (auto &slot : buckets[i].entries) {
+      auto e = load(slot);
+      if (e.get_bound() != bound::none && e.get_generation() == generation)
+        used++;
+    }
+  return static_cast<int>(used * 1000 / (samples * bucket_size));
+}
+
+}  // namespace abra
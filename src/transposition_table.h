@@ -0,0 +1,77 @@
+#ifndef ABRA_TRANSPOSITION_TABLE_H
+#define ABRA_TRANSPOSITION_TABLE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+namespace abra {
+
+// type of score stored for a node
+enum class bound : uint8_t { none, upper, lower, exact };
+
+// a compact 8 byte entry, the remaining key bits come from the bucket index
+struct tt_entry {
+  uint16_t key16;      // hash verification bits
+  uint16_t move16;     // packed move
+  int16_t score;       // search score
+  int8_t depth;        // remaining search depth
+  uint8_t gen_bound;   // generation (upper 6 bits) and bound (lower 2 bits)
+
+  bound get_bound() const;
+  uint8_t get_generation() const;
+  move get_move() const;
+};
+
+// fixed-size hash table of search results, indexed by zobrist key
+// buckets share a cache line and are replaced by depth and age
+// every entry is read and written as one atomic 64 bit word, so search
+// threads share the table without locks and never see a torn entry
+class transposition_table {
+  static const int bucket_size = 4;
+  struct alignas(32) bucket {
+    std::atomic<uint64_t> entries[bucket_size];
+  };
+
+  std::vector<bucket> buckets;
+  size_t mask;
+  uint8_t generation;
+
+ public:
+  // size in MB, rounded down to a power of two number of buckets
+  transposition_table(size_t = 16);
+
+  // reallocate (and clear) the table
+  void resize(size_t);
+
+  // forget all entries
+  void clear();
+
+  // advance generation, call once per search so older entries age out
+  void new_search();
+
+  // find entry for key, returns false if not present
+  bool probe(uint64_t, tt_entry &) const;
+
+  // store search result for key
+  void store(uint64_t, move, int, int, bound);
+
+  // permille of sampled entries written in the current generation
+  int hashfull() const;
+};
+
+inline bound tt_entry::get_bound() const {
+  return static_cast<bound>(gen_bound & 3);
+}
+
+inline uint8_t tt_entry::get_generation() const { return gen_bound >> 2; }
+
+static_assert(sizeof(tt_entry) == sizeof(uint64_t),
+              "tt_entry is stored as a single 64 bit word");
+
+}  // namespace abra
+
+#endif
@@ -1,18 +1,29 @@
 #ifndef ABRA_TYPES_H
 #define ABRA_TYPES_H
 
-#include <bitset>
 #include <cassert>
 #include <cstdint>
 #include <utility>
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 namespace abra {
 
 // represent color flags for pieces
-enum class color { none, white, black };
+enum class color : uint8_t { none, white, black };
 
 // represent piece type flags for pieces
-enum class piece_type { empty, pawn, knight, bishop, rook, queen, king };
+enum class piece_type : uint8_t {
+  empty,
+  pawn,
+  knight,
+  bishop,
+  rook,
+  queen,
+  king
+};
 
 // to index 64 bit board
 using square = int;
@@ -27,21 +38,125 @@ struct piece {
   bool operator==(const piece &) const;
 };
 
+inline piece::piece() : pcolor{color::none}, ptype{piece_type::empty} {}
+inline piece::piece(color _color, piece_type _type)
+    : pcolor{_color}, ptype{_type} {
+  assert(_color != color::none);
+  assert(_type != piece_type::empty);
+}
+
 inline bool piece::operator==(const piece &other) const {
   return pcolor == other.pcolor && ptype == other.ptype;
 }
 
-// represent a move
-struct move {
-  square from, to;
-  piece promotion;
-  move(square = 0, square = 0, piece = {});
+// special moves, which make_move cannot tell from the squares alone
+enum class move_flag : uint8_t { normal, promotion, en_passant, castling };
+
+// represent a move packed in 16 bits
+// from (6 bits), to (6 bits), promotion piece (2 bits), flag (2 bits)
+class move {
+  uint16_t data;
+
+ public:
+  // move{} (a8 to a8) doubles as "no move", left uninitialized otherwise
+  // so that move lists are cheap to create
+  move() = default;
+  move(square, square, move_flag = move_flag::normal,
+       piece_type = piece_type::knight);
+
+  square from() const;
+  square to() const;
+  move_flag flag() const;
+  // promoted piece type, empty if not a promotion
+  piece_type promotion() const;
+
+  // packed representation, for storing in tables
+  uint16_t raw() const;
+  static move from_raw(uint16_t);
+
   bool operator==(const move &) const;
+  bool operator!=(const move &) const;
 };
 
+inline move::move(square _from, square _to, move_flag _flag,
+                  piece_type _promotion)
+    : data{static_cast<uint16_t>(
+          _from | (_to << 6) |
+          ((static_cast<int>(_promotion) - static_cast<int>(piece_type::knight))
+           << 12) |
+          (static_cast<int>(_flag) << 14))} {
+  assert(piece_type::knight <= _promotion && _promotion <= piece_type::queen);
+}
+
+inline square move::from() const { return data & 63; }
+inline square move::to() const { return (data >> 6) & 63; }
+inline move_flag move::flag() const {
+  return static_cast<move_flag>(data >> 14);
+}
+inline piece_type move::promotion() const {
+  if (flag() != move_flag::promotion) return piece_type::empty;
+  return static_cast<piece_type>(((data >> 12) & 3) +
+                                 static_cast<int>(piece_type::knight));
+}
+inline uint16_t move::raw() const { return data; }
+inline move move::from_raw(uint16_t raw) {
+  auto m = move{};
+  m.data = raw;
+  return m;
+}
+
 inline bool move::operator==(const move &other) const {
-  return from == other.from && to == other.to && promotion == other.promotion;
+  return data == other.data;
+}
+
+inline bool move::operator!=(const move &other) const {
+  return data != other.data;
+}
+
+// fixed capacity list of moves which lives on the stack (no allocation)
+// 256 is more than the maximum number of legal moves in any position
+class move_list {
+  static const int capacity = 256;
+  move moves[capacity];
+  int count;
+
+ public:
+  move_list();
+
+  template <typename... Args>
+  void emplace_back(Args... args);
+  void push_back(move);
+  void clear();
+
+  int size() const;
+  bool empty() const;
+  move &operator[](int);
+  move operator[](int) const;
+  move *begin();
+  move *end();
+  const move *begin() const;
+  const move *end() const;
+};
+
+inline move_list::move_list() : count{0} {}
+
+template <typename... Args>
+inline void move_list::emplace_back(Args... args) {
+  push_back(move{args...});
 }
+inline void move_list::push_back(move m) {
+  assert(count < capacity);
+  moves[count++] = m;
+}
+inline void move_list::clear() { count = 0; }
+inline int move_list::size() const { return count; }
+inline bool move_list::empty() const { return count == 0; }
+inline move &move_list::operator[](int i) { return moves[i]; }
+inline move move_list::operator[](int i) const { return moves[i]; }
+inline move *move_list::begin() { return moves; }
+inline move *move_list::end() { return moves + count; }
+inline const move *move_list::begin() const { return moves; }
+inline const move *move_list::end() const { return moves + count; }
 
 // represent castling rights
 struct castle_rights {
@@ -69,17 +184,26 @@ inline bool castle_rights::operator!=(const castle_rights &other) const {
 using bitboard = uint64_t;
 
 // interface for piece placement
+// the bitboards answer set queries, a mailbox of pieces per square answers
+// "what is on this square", both are kept in sync by the modifiers below
 struct board64 {
   bitboard white, black, pawn, knight, bishop, rook, queen, king;
 
+ private:
+  piece pieces[64];
+
+  bitboard &get_colorb(color);
+  bitboard &get_typeb(piece_type);
+
+ public:
   board64();
 
-  // rotate board individually
+  // rotate board by 180 degrees
   void rotate();
 
-  // clear a piece from a square
+  // clear a piece from a square (if any)
   void clear_piece(square);
-  // move piece from square to square (does not modify "initial square")
+  // move piece from square to an empty square
   void move_piece(square, square);
 
   // set piece at square (overwrites)
@@ -130,23 +254,130 @@ inline constexpr bool test_bit(const bitboard &b, square i) {
 inline constexpr void move_bit(bitboard &b, square f, square t) {
   if (test_bit(b, f) != test_bit(b, t)) flip_bit(b, t);
 }
-inline int popcount(const bitboard &b) {
-  return static_cast<int>(std::bitset<64>{b}.count());
-}
-// bit twiddling hack
-inline void reverse_bits32(uint32_t &n) {
-  n = (n >> 16) | (n << 16);
-  n = ((n & 0xff00ff00) >> 8) | ((n & 0x00ff00ff) << 8);
-  n = ((n & 0xf0f0f0f0) >> 4) | ((n & 0x0f0f0f0f) << 4);
-  n = ((n & 0xcccccccc) >> 2) | ((n & 0x33333333) << 2);
-  n = ((n & 0xaaaaaaaa) >> 1) | ((n & 0x55555555) << 1);
-}
-inline void reverse_bits(bitboard &b) {
-  uint32_t left = (b >> 32), right = b;
-  reverse_bits32(left);
-  reverse_bits32(right);
-  b = right;
-  b = (b << 32) | left;
+
+// bit primitives, compiler intrinsics where available with a portable
+// fallback, see https://www.chessprogramming.org/Bitboard_Serialization
+
+// number of set bits
+inline int popcount(bitboard b) {
+#if defined(__GNUC__)
+  return __builtin_popcountll(b);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  return static_cast<int>(__popcnt64(b));
+#else
+  // swar population count
+  b = b - ((b >> 1) & 0x5555555555555555);
+  b = (b & 0x3333333333333333) + ((b >> 2) & 0x3333333333333333);
+  b = (b + (b >> 4)) & 0x0f0f0f0f0f0f0f0f;
+  return static_cast<int>((b * 0x0101010101010101) >> 56);
+#endif
+}
+
+// index of the least significant set bit (b should not be empty)
+inline square lsb(bitboard b) {
+  assert(b);
+#if defined(__GNUC__)
+  return __builtin_ctzll(b);
+#elif defined(_MSC_VER) && defined(_M_X64)
+  unsigned long i;
+  _BitScanForward64(&i, b);
+  return static_cast<square>(i);
+#else
+  // isolate the bit and count the ones below it
+  return popcount((b & -b) - 1);
+#endif
+}
+
+// remove and return the least significant set bit, to iterate with
+// `while (b) { auto s = pop_lsb(b); ... }`
+inline square pop_lsb(bitboard &b) {
+  auto s = lsb(b);
+  b &= b - 1;
+  return s;
+}
+
+// true iff more than one bit is set
+inline constexpr bool more_than_one(bitboard b) { return b & (b - 1); }
+
+// mirror the ranks (row r becomes row 7 - r), a single byte swap
+inline bitboard flip_vertical(bitboard b) {
+#if defined(__GNUC__)
+  return __builtin_bswap64(b);
+#elif defined(_MSC_VER)
+  return _byteswap_uint64(b);
+#else
+  b = ((b >> 8) & 0x00ff00ff00ff00ff) | ((b & 0x00ff00ff00ff00ff) << 8);
+  b = ((b >> 16) & 0x0000ffff0000ffff) | ((b & 0x0000ffff0000ffff) << 16);
+  return (b >> 32) | (b << 32);
+#endif
+}
+
+// mirror the files (column c becomes column 7 - c)
+inline constexpr bitboard mirror_horizontal(bitboard b) {
+  b = ((b >> 1) & 0x5555555555555555) | ((b & 0x5555555555555555) << 1);
+  b = ((b >> 2) & 0x3333333333333333) | ((b & 0x3333333333333333) << 2);
+  return ((b >> 4) & 0x0f0f0f0f0f0f0f0f) | ((b & 0x0f0f0f0f0f0f0f0f) << 4);
+}
+
+// square as seen from the other side (same file, mirrored rank)
+inline constexpr square flip_square(square s) { return s ^ 56; }
+
+inline bitboard &board64::get_colorb(color c) {
+  assert(c != color::none);
+  return (c == color::white ? white : black);
+}
+
+inline bitboard &board64::get_typeb(piece_type t) {
+  switch (t) {
+    case piece_type::pawn:
+      return pawn;
+    case piece_type::knight:
+      return knight;
+    case piece_type::bishop:
+      return bishop;
+    case piece_type::rook:
+      return rook;
+    case piece_type::queen:
+      return queen;
+    case piece_type::king:
+    default:
+      assert(t == piece_type::king && "piece type is empty");
+      return king;
+  }
+}
+
+inline void board64::clear_piece(square i) {
+  assert(is_valid_square(i));
+  auto p = pieces[i];
+  if (p.is_empty()) return;
+  reset_bit(get_colorb(p.pcolor), i);
+  reset_bit(get_typeb(p.ptype), i);
+  pieces[i] = piece{};
+}
+
+inline void board64::move_piece(square i, square j) {
+  assert(is_valid_square(i) && is_valid_square(j));
+  assert(pieces[j].is_empty());
+  auto p = pieces[i];
+  if (p.is_empty()) return;
+  auto mask = to_bitboard(i) | to_bitboard(j);
+  get_colorb(p.pcolor) ^= mask;
+  get_typeb(p.ptype) ^= mask;
+  pieces[j] = p;
+  pieces[i] = piece{};
+}
+
+inline void board64::set_piece(square i, piece x) {
+  assert(is_valid_square(i) && !x.is_empty());
+  clear_piece(i);
+  set_bit(get_colorb(x.pcolor), i);
+  set_bit(get_typeb(x.ptype), i);
+  pieces[i] = x;
+}
+
+inline piece board64::get_piece(square i) const {
+  assert(is_valid_square(i));
+  return pieces[i];
 }
 
 }  // namespace abra
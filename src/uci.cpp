@@ -0,0 +1,256 @@
+#include "uci.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "game.h"
+#include "nnue.h"
+#include "notation.h"
+#include "search.h"
+#include "types.h"
+
+namespace abra::uci {
+
+namespace {
+
+const std::string engine_name{"abra"};
+const std::string start_fen{
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"};
+
+// info lines come from the worker while the loop answers commands
+std::mutex output_mutex;
+
+void send(const std::string &line) {
+  auto lock = std::lock_guard<std::mutex>{output_mutex};
+  std::cout << line << std::endl;
+}
+
+// find the legal move written in long algebraic notation
+move parse_move(const game &g, const std::string &an) {
+  auto mv = notation::to_move(an);
+  auto moves = move_list{};
+  g.get_moves(moves);
+  auto it = std::find_if(moves.begin(), moves.end(), [&](move m) {
+    return notation::to_AN(m) == notation::to_AN(mv);
+  });
+  if (it == moves.end())
+    throw new std::invalid_argument("illegal move '" + an + "'");
+  return *it;
+}
+
+// position [startpos | fen <fen>] [moves <move>...]
+game parse_position(std::istringstream &is) {
+  auto token = std::string{}, fen = std::string{};
+  is >> token;
+  if (token == "startpos") {
+    fen = start_fen;
+    is >> token;
+  } else if (token == "fen") {
+    while (is >> token && token != "moves")
+      fen += (fen.empty() ? "" : " ") + token;
+  } else {
+    throw new std::invalid_argument("invalid position '" + token + "'");
+  }
+  auto g = game{fen};
+  if (token == "moves")
+    while (is >> token) g.make_move(parse_move(g, token));
+  return g;
+}
+
+// go [wtime <ms>] [btime <ms>] [winc <ms>] [binc <ms>] [movestogo <n>]
+//    [depth <n>] [nodes <n>] [movetime <ms>] [infinite]
+search_limits parse_go(std::istringstream &is, color side) {
+  auto limits = search_limits{};
+  auto white = (side == color::white);
+  auto token = std::string{};
+  while (is >> token) {
+    if (token == "infinite") {
+      limits.infinite = true;
+      continue;
+    }
+    auto value = int64_t{0};
+    if (!(is >> value))
+      throw new std::invalid_argument(token + " does not have a value");
+    // a clock of 0 or less is still a clock, one that has run out
+    if ((token == "wtime" && white) || (token == "btime" && !white))
+      limits.has_clock = true;
+    if (token == "wtime" && white)
+      limits.clock = static_cast<int>(value);
+    else if (token == "btime" && !white)
+      limits.clock = static_cast<int>(value);
+    else if (token == "winc" && white)
+      limits.increment = static_cast<int>(value);
+    else if (token == "binc" && !white)
+      limits.increment = static_cast<int>(value);
+    else if (token == "movestogo")
+      limits.moves_to_go = static_cast<int>(value);
+    else if (token == "depth")
+      limits.depth = static_cast<int>(value);
+    else if (token == "nodes")
+      limits.nodes = static_cast<uint64_t>(value);
+    else if (token == "movetime")
+      limits.movetime = static_cast<int>(value);
+  }
+  return limits;
+}
+
+size_t parse_number(const std::string &value) {
+  try {
+    return std::stoul(value);
+  } catch (const std::exception &) {
+    throw new std::invalid_argument("invalid number '" + value + "'");
+  }
+}
+
+search_driver parse_driver(const std::string &value) {
+  if (value == "mtdf") return search_driver::mtdf;
+  if (value == "pvs") return search_driver::pvs;
+  throw new std::invalid_argument("unknown driver '" + value + "'");
+}
+
+bool parse_check(const std::string &value) {
+  if (value == "true") return true;
+  if (value == "false") return false;
+  throw new std::invalid_argument("invalid check value '" + value + "'");
+}
+
+std::string format_info(const search_info &info, color side) {
+  auto os = std::ostringstream{};
+  auto score = (side == color::white ? info.score : -info.score);
+  auto nps = (info.time_ms > 0 ? info.nodes * 1000 / info.time_ms : 0);
+  os << "info depth " << info.depth << " score ";
+  if (std::abs(score) >= mate_bound)
+    os << "mate " << mate_in(score);
+  else
+    os << "cp " << score;
+  os << " nodes " << info.nodes << " nps " << nps << " hashfull "
+     << info.hashfull << " time " << info.time_ms << " pv";
+  for (auto m : info.pv) os << " " << notation::to_AN(m);
+  return os.str();
+}
+
+}  // namespace
+
+void loop(size_t hash_mb, const std::string &eval_file) {
+  auto search = minimax_search{hash_mb};
+  // an empty path goes back to the piece-square evaluation
+  auto load_network = [&](const std::string &path) {
+    if (path.empty() || path == "<empty>") {
+      search.set_network(nullptr);
+      return;
+    }
+    search.set_network(nnue::load(path));
+    send("info string loaded network " + path + " with " +
+         nnue::simd_name() + " kernels");
+  };
+  load_network(eval_file);
+  auto options = search_options{};
+  auto pos = game{start_fen};
+  auto stop = std::atomic<bool>{false};
+  auto worker = std::thread{};
+
+  auto wait_for_search = [&]() {
+    if (worker.joinable()) worker.join();
+  };
+  auto stop_search = [&]() {
+    stop = true;
+    wait_for_search();
+  };
+
+  auto line = std::string{};
+  while (std::getline(std::cin, line)) {
+    auto is = std::istringstream{line};
+    auto command = std::string{};
+    is >> command;
+    try {
+      if (command == "uci") {
+        send("id name " + engine_name);
+        send("id author abrahamfrancis");
+        send("option name Hash type spin default " + std::to_string(hash_mb) +
+             " min 1 max 4096");
+        send("option name Threads type spin default 1 min 1 max 256");
+        send("option name Driver type combo default pvs var mtdf var pvs");
+        send("option name NullMove type check default true");
+        send("option name LMR type check default true");
+        send("option name Futility type check default true");
+        send("option name EvalFile type string default " +
+             (eval_file.empty() ? std::string{"<empty>"} : eval_file));
+        send("uciok");
+      } else if (command == "isready") {
+        send("readyok");
+      } else if (command == "ucinewgame") {
+        stop_search();
+        search.clear();
+      } else if (command == "setoption") {
+        // setoption name <id> value <x>, the value may contain spaces
+        auto token = std::string{}, name = std::string{};
+        auto value = std::string{};
+        is >> token >> name >> token;
+        std::getline(is >> std::ws, value);
+        stop_search();
+        if (name == "Hash")
+          search.set_hash_size(std::max<size_t>(parse_number(value), 1));
+        else if (name == "Threads")
+          search.set_threads(
+              static_cast<int>(std::min<size_t>(parse_number(value), 256)));
+        else if (name == "Driver")
+          search.set_driver(parse_driver(value));
+        else if (name == "NullMove")
+          options.null_move = parse_check(value);
+        else if (name == "LMR")
+          options.reductions = parse_check(value);
+        else if (name == "Futility")
+          options.futility = parse_check(value);
+        else if (name == "EvalFile")
+          load_network(value);
+        else
+          send("info string unknown option " + name);
+        search.set_options(options);
+      } else if (command == "position") {
+        stop_search();
+        pos = parse_position(is);
+      } else if (command == "go") {
+        stop_search();
+        stop = false;
+        auto side = pos.get_color_to_move();
+        auto limits = parse_go(is, side);
+        limits.stop = &stop;
+        search.set_info_callback([side](const search_info &info) {
+          send(format_info(info, side));
+        });
+        worker = std::thread{[&search, &stop, pos, limits]() {
+          auto moves = move_list{};
+          pos.get_moves(moves);
+          auto best = std::string{"0000"};  // null move, the game is over
+          if (!moves.empty())
+            best = notation::to_AN(search.choose_move(pos, limits).second);
+          // with infinite the best move may only be sent after stop
+          while (limits.infinite && !stop)
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+          send("bestmove " + best);
+        }};
+      } else if (command == "stop") {
+        stop_search();
+      } else if (command == "quit") {
+        break;
+      }
+    } catch (std::invalid_argument *err) {
+      send("info string " + std::string{err->what()});
+    } catch (const std::exception &err) {
+      // standard library parsing (stoi in game's fen) throws by value
+      send("info string " + std::string{err.what()});
+    }
+  }
+  stop_search();
+}
+
+}  // namespace abra::uci
@@ -0,0 +1,18 @@
+#ifndef ABRA_UCI_H
+#define ABRA_UCI_H
+
+#include <cstddef>
+#include <string>
+
+// universal chess interface front end, see
+// https://www.chessprogramming.org/UCI
+namespace abra::uci {
+
+// read commands from stdin until "quit", searching on a worker thread
+// so that "stop" and "isready" are answered while thinking
+// eval_file is the network to evaluate with, empty for piece-square tables
+void loop(size_t hash_mb, const std::string &eval_file);
+
+}  // namespace abra::uci
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef ABRA_ZOBRIST_H
+#define ABRA_ZOBRIST_H
+
+#include <cstdint>
+
+#include "types.h"
+
+// keys for zobrist hashing, see https://www.chessprogramming.org/Zobrist_Hashing
+namespace abra::zobrist {
+
+struct key_table {
+  uint64_t pieces[2][6][64];
+  uint64_t black_to_move;
+  uint64_t castlings[4];
+  uint64_t ep_files[8];
+};
+
+// generated at compile time with splitmix64 and a fixed seed, so hashes
+// are the same on every run
+constexpr key_table make_keys() {
+  auto keys = key_table{};
+  auto seed = uint64_t{0x3243f6a8885a308d};
+  auto next = [&seed]() {
+    auto z = (seed += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+  };
+  for (auto &per_color : keys.pieces)
+    for (auto &per_type : per_color)
+      for (auto &k : per_type) k = next();
+  keys.black_to_move = next();
+  for (auto &k : keys.castlings) k = next();
+  for (auto &k : keys.ep_files) k = next();
+  return keys;
+}
+
+inline constexpr key_table keys = make_keys();
+
+inline uint64_t piece_key(piece p, square s) {
+  assert(!p.is_empty() && is_valid_square(s));
+  auto c = static_cast<int>(p.pcolor) - 1, t = static_cast<int>(p.ptype) - 1;
+  return keys.pieces[c][t][s];
+}
+
+// the pawn hash key only covers pawns and kings
+inline uint64_t pawn_key(piece p, square s) {
+  return (p.ptype == piece_type::pawn || p.ptype == piece_type::king
+              ? piece_key(p, s)
+              : 0);
+}
+
+inline uint64_t side_key(color c) {
+  return (c == color::black ? keys.black_to_move : 0);
+}
+
+inline uint64_t castling_key(castle_rights r) {
+  auto key = uint64_t{0};
+  if (r.white_short) key ^= keys.castlings[0];
+  if (r.white_long) key ^= keys.castlings[1];
+  if (r.black_short) key ^= keys.castlings[2];
+  if (r.black_long) key ^= keys.castlings[3];
+  return key;
+}
+
+inline uint64_t en_passant_key(square s) {
+  return (is_valid_square(s) ? keys.ep_files[get_col(s)] : 0);
+}
+
+}  // namespace abra::zobrist
+
+#endif